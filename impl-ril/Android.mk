@@ -8,8 +8,11 @@ include $(CLEAR_VARS)
 LOCAL_SRC_FILES := \
     common/at_tok.c \
     common/atchannel.c \
+    common/at_engine.c \
     common/misc.c \
     common/utils.c \
+    common/codec.c \
+    common/prop_cache.c \
     common/channel_controller.c \
     custom/ril_custom.c \
     impl_ril.c \
@@ -83,4 +86,6 @@ LOCAL_MODULE_STEM_64 := impl-ril64
 LOCAL_MULTILIB := both
 include $(BUILD_EXECUTABLE)
 
-endif
\ No newline at end of file
+endif
+
+include $(LOCAL_PATH)/tests/Android.mk
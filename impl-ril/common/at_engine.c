@@ -0,0 +1,275 @@
+/**
+ * at_engine.c --- AT line framing and response handling shared by
+ *                 impl-ril and libril-lite
+ *
+ * Copyright (C) 2019 UNISOC Technologies Co.,Ltd.
+ */
+
+#define LOG_TAG "RIL-AT"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+#include "at_engine.h"
+#include "atchannel.h"
+#include "misc.h"
+
+#define NUM_ELEMS(x)            (sizeof(x) / sizeof(x[0]))
+
+void at_reader_init(ATLineReader *reader, int fd, char *buffer,
+                    size_t bufferSize) {
+    reader->fd = fd;
+    reader->buffer = buffer;
+    reader->bufferSize = bufferSize;
+    memset(buffer, 0, bufferSize + 1);
+    reader->bufferCur = buffer;
+    reader->backup = NULL;
+    reader->backupLen = 0;
+}
+
+/**
+ * Returns a pointer to the end of the next line
+ * special-cases the "> " SMS prompt
+ *
+ * returns NULL if there is no complete line
+ */
+static char *findNextEOL(char *cur) {
+    if (cur[0] == '>' && cur[1] == ' ' && cur[2] == '\0') {
+        /* SMS prompt character...not \r terminated */
+        return cur+2;
+    }
+
+    // Find next newline
+    while (*cur != '\0' && *cur != '\r' && *cur != '\n') cur++;
+
+    return *cur == '\0' ? NULL : cur;
+}
+
+static void skipNewlines(ATLineReader *reader) {
+    while (*reader->bufferCur == '\r' || *reader->bufferCur == '\n') {
+        reader->bufferCur++;
+    }
+}
+
+/* moves the unterminated tail of a full buffer into the backup line */
+static void spillToBackup(ATLineReader *reader, int terminate) {
+    size_t len = strlen(reader->bufferCur);
+
+    reader->backup = (char *)realloc(reader->backup,
+            reader->backupLen + len + 1);
+    memcpy(reader->backup + reader->backupLen, reader->bufferCur, len);
+    reader->backupLen += len;
+    if (terminate) {
+        reader->backup[reader->backupLen] = '\0';
+    }
+}
+
+char *at_reader_readline(ATLineReader *reader) {
+    ssize_t count;
+    char *p_read = NULL;
+    char *p_eol = NULL;
+    char *line = NULL;
+    /* Add for 321528 @{ */
+    ssize_t err_count = 0;
+    /* @} */
+
+    /* the over-long line handed out by the previous call */
+    if (reader->backup != NULL && reader->backupLen == 0) {
+        free(reader->backup);
+        reader->backup = NULL;
+    }
+
+    /* this is a little odd. I use *bufferCur == 0 to
+     * mean "buffer consumed completely". If it points to a character, than
+     * the buffer continues until a \0
+     */
+    if (*reader->bufferCur == '\0') {
+        /* empty buffer */
+        reader->bufferCur = reader->buffer;
+        *reader->bufferCur = '\0';
+        p_read = reader->buffer;
+    } else {   /* *bufferCur != '\0' */
+        /* there's data in the buffer from the last read */
+        skipNewlines(reader);
+
+        p_eol = findNextEOL(reader->bufferCur);
+
+        if (p_eol == NULL) {
+            /* a partial line. move it up and prepare to read more */
+            size_t len;
+
+            len = strlen(reader->bufferCur);
+
+            memmove(reader->buffer, reader->bufferCur, len + 1);
+            p_read = reader->buffer + len;
+            reader->bufferCur = reader->buffer;
+        }
+        /* Otherwise, (p_eol !- NULL) there is a complete line  */
+        /* that will be returned the while () loop below        */
+    }
+
+    while (p_eol == NULL) {
+        if (0 == reader->bufferSize - (p_read - reader->buffer)) {
+            RLOGE("Input line exceeded buffer, realloc memory to store AT line");
+            spillToBackup(reader, 0);
+
+            /* ditch buffer and start over again */
+            reader->bufferCur = reader->buffer;
+            *reader->bufferCur = '\0';
+            p_read = reader->buffer;
+        }
+
+        do {
+            count = read(reader->fd, p_read,
+                         reader->bufferSize - (p_read - reader->buffer));
+        } while (count < 0 && errno == EINTR);
+
+        if (count > 0) {
+            AT_DUMP("<< ", p_read, count);
+
+            p_read[count] = '\0';
+
+            if (*reader->bufferCur == '\r' && reader->backup != NULL) {
+                p_eol = reader->bufferCur;
+            } else {
+                skipNewlines(reader);
+                p_eol = findNextEOL(reader->bufferCur);
+            }
+            p_read += count;
+            /* Add for 321528 @{ */
+            err_count = 0;
+            /* @} */
+        } else if (count <= 0) {
+            /* read error encountered or EOF reached */
+            if (count == 0) {
+                /* Add for 321528 @{ */
+                err_count++;
+                if (err_count > 10) {
+                    RLOGD("atchannel: EOF reached. Sleep 10s");
+                    sleep(10);
+                } else {
+                    RLOGD("atchannel: EOF reached. err_count = %zd", err_count);
+                }
+                /* @} */
+            }
+            return NULL;
+        }
+    }
+
+    /* a full line in the buffer. Place a \0 over the \r and return */
+    *p_eol = '\0';
+    if (reader->backup != NULL) {
+        spillToBackup(reader, 1);
+        reader->backupLen = 0;
+        line = reader->backup;
+    } else {
+        line = reader->bufferCur;
+    }
+    reader->bufferCur = p_eol + 1;  /* this will always be <= p_read,
+                                       and there will be a \0 at *p_read */
+    return line;
+}
+
+ATResponse *at_response_new() {
+    return (ATResponse *)calloc(1, sizeof(ATResponse));
+}
+
+void at_response_free(ATResponse *p_response) {
+    ATLine *p_line;
+
+    if (p_response == NULL) return;
+
+    p_line = p_response->p_intermediates;
+
+    while (p_line != NULL) {
+        ATLine *p_toFree;
+
+        p_toFree = p_line;
+        p_line = p_line->p_next;
+
+        free(p_toFree->line);
+        free(p_toFree);
+    }
+
+    free(p_response->finalResponse);
+    free(p_response);
+}
+
+void at_response_add_line(ATResponse *p_response, const char *line) {
+    ATLine *p_new;
+
+    p_new = (ATLine *)malloc(sizeof(ATLine));
+
+    p_new->line = strdup(line);
+
+    /* note: this adds to the head of the list, so the list
+       will be in reverse order of lines received. the order is flipped
+       again before passing on to the command issuer */
+    p_new->p_next = p_response->p_intermediates;
+    p_response->p_intermediates = p_new;
+}
+
+void at_response_reverse(ATResponse *p_response) {
+    ATLine *pcur, *pnext;
+
+    pcur = p_response->p_intermediates;
+    p_response->p_intermediates = NULL;
+
+    while (pcur != NULL) {
+        pnext = pcur->p_next;
+        pcur->p_next = p_response->p_intermediates;
+        p_response->p_intermediates = pcur;
+        pcur = pnext;
+    }
+}
+
+/**
+ * returns 1 if line is a final response indicating error
+ * See 27.007 annex B
+ * WARNING: NO CARRIER and others are sometimes unsolicited
+ */
+static const char *s_finalResponsesError[] = {
+    "ERROR",
+    "+CMS ERROR:",
+    "+CME ERROR:",
+    "NO CARRIER", /* sometimes! */
+    "NO ANSWER",
+    "NO DIALTONE",
+};
+
+int isFinalResponseError(const char *line) {
+    size_t i;
+
+    for (i = 0; i < NUM_ELEMS(s_finalResponsesError); i++) {
+        if (strStartsWith(line, s_finalResponsesError[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * returns 1 if line is a final response indicating success
+ * See 27.007 annex B
+ * WARNING: NO CARRIER and others are sometimes unsolicited
+ */
+static const char *s_finalResponsesSuccess[] = {
+    "OK",
+    "CONNECT"  /* some stacks start up data on another channel */
+};
+
+int isFinalResponseSuccess(const char *line) {
+    size_t i;
+
+    for (i = 0; i < NUM_ELEMS(s_finalResponsesSuccess); i++) {
+        if (strStartsWith(line, s_finalResponsesSuccess[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+/**
+ * at_engine.h --- AT line framing and response handling shared by
+ *                 impl-ril and libril-lite
+ *
+ * Copyright (C) 2019 UNISOC Technologies Co.,Ltd.
+ */
+
+#ifndef AT_ENGINE_H_
+#define AT_ENGINE_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** a singly-lined list of intermediate responses */
+typedef struct ATLine  {
+    struct ATLine *p_next;
+    char *line;
+} ATLine;
+
+/** Free this with at_response_free() */
+typedef struct {
+    int success;                /* true if final response indicates
+                                    success (eg "OK") */
+    char *finalResponse;        /* eg OK, ERROR */
+    ATLine *p_intermediates;    /* any intermediate responses */
+} ATResponse;
+
+/**
+ * Splits the byte stream of one AT channel into response lines.
+ * The buffer belongs to the caller and must hold bufferSize + 1 bytes.
+ */
+typedef struct ATLineReader {
+    int fd;
+    char *buffer;
+    size_t bufferSize;
+    char *bufferCur;
+    char *backup;       /* a line longer than the buffer, kept across reads */
+    size_t backupLen;   /* 0 once the backup line has been returned */
+} ATLineReader;
+
+void at_reader_init(ATLineReader *reader, int fd, char *buffer,
+                    size_t bufferSize);
+
+/**
+ * Reads a line from the channel, returns NULL if no complete line is
+ * available (EOF, read error or EAGAIN on a non-blocking fd).
+ * Assumes it has exclusive read access to the fd.
+ *
+ * The line is valid only until the next call to at_reader_readline()
+ */
+char *at_reader_readline(ATLineReader *reader);
+
+ATResponse *at_response_new();
+void at_response_free(ATResponse *p_response);
+
+/**
+ * Adds a copy of line to the intermediates. The list is kept in reverse
+ * order of arrival, call at_response_reverse() once the command is done.
+ */
+void at_response_add_line(ATResponse *p_response, const char *line);
+void at_response_reverse(ATResponse *p_response);
+
+int isFinalResponseError(const char *line);
+int isFinalResponseSuccess(const char *line);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // AT_ENGINE_H_
@@ -18,6 +18,8 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
 
 /**
  * Starts tokenizing an AT response string
@@ -189,3 +191,207 @@ int at_tok_flag_start(char **p_cur, char start_flag) {
     (*p_cur)++;
     return 0;
 }
+
+int at_cursor_start(ATCursor *p_cur, const char *line) {
+    p_cur->cur = NULL;
+    p_cur->field = 0;
+
+    if (line == NULL) {
+        return -1;
+    }
+
+    // skip prefix
+    // consume "^[^:]:"
+    line = strchr(line, ':');
+    if (line == NULL) {
+        return -1;
+    }
+    p_cur->cur = line + 1;
+
+    return 0;
+}
+
+/** returns 1 on "has more tokens" and 0 if no */
+int at_cursor_hasmore(const ATCursor *p_cur) {
+    return !(p_cur->cur == NULL || *p_cur->cur == '\0');
+}
+
+/**
+ * Finds the bounds of the next field, without its quotes, and moves the
+ * cursor past the comma following it.
+ * returns NULL at the end of the line
+ */
+static const char *nextField(ATCursor *p_cur, size_t *p_len) {
+    const char *cur = p_cur->cur;
+    const char *start = NULL;
+    const char *end = NULL;
+
+    if (!at_cursor_hasmore(p_cur)) {
+        return NULL;
+    }
+
+    while (*cur != '\0' && isspace((unsigned char)*cur)) {
+        cur++;
+    }
+
+    if (*cur == '"') {
+        start = ++cur;
+        while (*cur != '\0' && *cur != '"') {
+            cur++;
+        }
+        end = cur;
+    } else {
+        start = cur;
+    }
+    while (*cur != '\0' && *cur != ',') {
+        cur++;
+    }
+    if (end == NULL) {
+        end = cur;
+    }
+    if (*cur == ',') {
+        cur++;
+    }
+
+    p_cur->cur = cur;
+    *p_len = end - start;
+    return start;
+}
+
+static int parseInt(const char *start, size_t len, int base, int *p_out) {
+    long l;
+    char *end;
+
+    if (len == 0) {
+        return -1;
+    }
+
+    if (base == 16) {
+        l = strtoul(start, &end, base);
+    } else {
+        l = strtol(start, &end, base);
+    }
+    if (end == start || end > start + len) {
+        return -1;
+    }
+
+    *p_out = (int)l;
+    return 0;
+}
+
+static void copyField(const char *start, size_t len, char *out,
+                      size_t size) {
+    if (out == NULL || size == 0) {
+        return;
+    }
+    if (len > size - 1) {
+        len = size - 1;
+    }
+    memcpy(out, start, len);
+    out[len] = '\0';
+}
+
+static int at_cursor_nextint_base(ATCursor *p_cur, int *p_out, int base) {
+    size_t len = 0;
+    const char *start = nextField(p_cur, &len);
+
+    if (start == NULL || parseInt(start, len, base, p_out) < 0) {
+        return -1;
+    }
+    p_cur->field++;
+    return 0;
+}
+
+int at_cursor_nextint(ATCursor *p_cur, int *p_out) {
+    return at_cursor_nextint_base(p_cur, p_out, 10);
+}
+
+int at_cursor_nexthexint(ATCursor *p_cur, int *p_out) {
+    return at_cursor_nextint_base(p_cur, p_out, 16);
+}
+
+int at_cursor_nextstr(ATCursor *p_cur, char *out, size_t size) {
+    size_t len = 0;
+    const char *start = nextField(p_cur, &len);
+
+    if (start == NULL) {
+        return -1;
+    }
+    copyField(start, len, out, size);
+    p_cur->field++;
+    return 0;
+}
+
+typedef enum {
+    SCAN_FIELD_INVALID,
+    SCAN_FIELD_INT,
+    SCAN_FIELD_HEX,
+    SCAN_FIELD_STR,
+    SCAN_FIELD_SKIP,
+} ScanFieldType;
+
+static ScanFieldType scanFieldType(const char *type, size_t len) {
+    if (len == 3 && !strncmp(type, "int", len)) {
+        return SCAN_FIELD_INT;
+    } else if (len == 3 && !strncmp(type, "hex", len)) {
+        return SCAN_FIELD_HEX;
+    } else if (len == 3 && !strncmp(type, "str", len)) {
+        return SCAN_FIELD_STR;
+    } else if (len == 4 && !strncmp(type, "skip", len)) {
+        return SCAN_FIELD_SKIP;
+    }
+    return SCAN_FIELD_INVALID;
+}
+
+int at_cursor_scan(ATCursor *p_cur, const char *schema, ...) {
+    int ret = 0;
+    int *p_int = NULL;
+    char *p_str = NULL;
+    size_t size = 0;
+    size_t len = 0;
+    size_t typeLen = 0;
+    bool optional = false;
+    const char *next = NULL;
+    const char *start = NULL;
+    ScanFieldType type = SCAN_FIELD_INVALID;
+    va_list ap;
+
+    va_start(ap, schema);
+    while (schema != NULL && *schema != '\0') {
+        next = strchr(schema, ',');
+        typeLen = (next != NULL) ? (size_t)(next - schema) : strlen(schema);
+        optional = typeLen > 0 && schema[typeLen - 1] == '?';
+        type = scanFieldType(schema, optional ? typeLen - 1 : typeLen);
+        schema = (next != NULL) ? next + 1 : NULL;
+
+        if (type == SCAN_FIELD_INT || type == SCAN_FIELD_HEX) {
+            p_int = va_arg(ap, int *);
+        } else if (type == SCAN_FIELD_STR) {
+            p_str = va_arg(ap, char *);
+            size = va_arg(ap, size_t);
+        } else if (type == SCAN_FIELD_INVALID) {
+            ret = -1;
+            break;
+        }
+
+        start = nextField(p_cur, &len);
+        if (start == NULL || (len == 0 && optional)) {
+            if (!optional) {
+                ret = -1;
+                break;
+            }
+        } else if (type == SCAN_FIELD_INT || type == SCAN_FIELD_HEX) {
+            if (parseInt(start, len, type == SCAN_FIELD_HEX ? 16 : 10,
+                         p_int) < 0) {
+                ret = -1;
+                break;
+            }
+        } else if (type == SCAN_FIELD_STR) {
+            copyField(start, len, p_str, size);
+        }
+        p_cur->field++;
+    }
+    va_end(ap);
+
+    return ret;
+}
@@ -17,6 +17,8 @@
 #ifndef AT_TOK_H_
 #define AT_TOK_H_
 
+#include <stddef.h>
+
 int at_tok_start(char **p_cur);
 int at_tok_nextint(char **p_cur, int *p_out);
 int at_tok_nexthexint(char **p_cur, int *p_out);
@@ -29,4 +31,33 @@ void skipNextComma(char **p_cur);
 void skipWhiteSpace(char **p_cur);
 int at_tok_flag_start(char **p_cur, char start_flag);
 
+/**
+ * Read-only tokenizer. Unlike at_tok_*, which writes NULs into the line,
+ * an ATCursor only moves over it, so a const line (e.g. an unsolicited
+ * response) can be parsed in place without strdup().
+ */
+typedef struct {
+    const char *cur;    /* next unread character */
+    int field;          /* index of the next field, of the bad one on error */
+} ATCursor;
+
+int at_cursor_start(ATCursor *p_cur, const char *line);
+int at_cursor_hasmore(const ATCursor *p_cur);
+int at_cursor_nextint(ATCursor *p_cur, int *p_out);
+int at_cursor_nexthexint(ATCursor *p_cur, int *p_out);
+/* copies the field into out, truncated to size - 1 characters */
+int at_cursor_nextstr(ATCursor *p_cur, char *out, size_t size);
+
+/**
+ * Parses the fields described by schema in one pass, e.g.
+ *   at_cursor_scan(&cur, "int,hex,str?,skip,int", &a, &b, buf, sizeof(buf), &c)
+ *
+ * int/hex take an int *, str takes a char * and its size_t size, skip
+ * takes nothing. A field marked with '?' may be empty or missing, its
+ * output is then left untouched, so preset it with the default.
+ * returns 0 on success and -1 on fail, p_cur->field then names the field
+ * that failed.
+ */
+int at_cursor_scan(ATCursor *p_cur, const char *schema, ...);
+
 #endif  // AT_TOK_H_
@@ -37,6 +37,7 @@
 #define LOG_NDEBUG              1
 #define HANDSHAKE_RETRY_COUNT   8
 #define HANDSHAKE_TIMEOUT_MSEC  250
+#define SMS_PDU_TIMEOUT_MSEC    5000
 #define NUM_ELEMS(x)            (sizeof(x) / sizeof(x[0]))
 
 int s_fdReaderLoopWakeupRead[SIM_COUNT];
@@ -56,6 +57,11 @@ extern int s_psOpened[SIM_COUNT];
 
 ReaderThread s_readerThread[SIM_COUNT];
 
+/* emergency lane, see acquireChannel() */
+pthread_t s_emergencyLaneTid;
+bool s_emergencyLaneStarted = false;
+static long long s_emergencyArrivalMsec = 0;  // only touched by the lane thread
+
 #if AT_DEBUG
 void  AT_DUMP(const char *prefix, const char *buff, int len) {
     if (len < 0) {
@@ -102,69 +108,6 @@ static void sleepMsec(long long msec) {
 }
 #endif
 
-/* add an intermediate response to sp_response */
-static void addIntermediate(struct ATChannels *ATch) {
-    ATLine *p_new;
-
-    p_new = (ATLine *)malloc(sizeof(ATLine));
-
-    p_new->line = strdup(ATch->line);
-
-    /* note: this adds to the head of the list, so the list
-       will be in reverse order of lines received. the order is flipped
-       again before passing on to the command issuer */
-    p_new->p_next = ATch->sp_response->p_intermediates;
-    ATch->sp_response->p_intermediates = p_new;
-}
-
-/**
- * returns 1 if line is a final response indicating error
- * See 27.007 annex B
- * WARNING: NO CARRIER and others are sometimes unsolicited
- */
-static const char *s_finalResponsesError[] = {
-    "ERROR",
-    "+CMS ERROR:",
-    "+CME ERROR:",
-    "NO CARRIER", /* sometimes! */
-    "NO ANSWER",
-    "NO DIALTONE",
-};
-
-int isFinalResponseError(const char *line) {
-    size_t i;
-
-    for (i = 0; i < NUM_ELEMS(s_finalResponsesError); i++) {
-        if (strStartsWith(line, s_finalResponsesError[i])) {
-            return 1;
-        }
-    }
-
-    return 0;
-}
-
-/**
- * returns 1 if line is a final response indicating success
- * See 27.007 annex B
- * WARNING: NO CARRIER and others are sometimes unsolicited
- */
-static const char *s_finalResponsesSuccess[] = {
-    "OK",
-    "CONNECT"  /* some stacks start up data on another channel */
-};
-
-int isFinalResponseSuccess(const char *line) {
-    size_t i;
-
-    for (i = 0; i < NUM_ELEMS(s_finalResponsesSuccess); i++) {
-        if (strStartsWith(line, s_finalResponsesSuccess[i])) {
-            return 1;
-        }
-    }
-
-    return 0;
-}
-
 #if 0  // unused function
 /**
  * returns 1 if line is a final response, either  error or success
@@ -199,12 +142,70 @@ static int isSMSUnsolicited(const char *line) {
     return 0;
 }
 
-static void at_backup_free(struct ATChannels *ATch) {
-    if (ATch != NULL && ATch->s_ATBackup != NULL) {
-        free(ATch->s_ATBackup);
-        ATch->s_ATBackup = NULL;
-        ATch->s_ATBackupLenCur = 0;
+long long getMonotonicMsec() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void clearSmsHeader(struct ATChannels *ATch) {
+    free(ATch->s_smsHeader);
+    ATch->s_smsHeader = NULL;
+}
+
+/**
+ * Drops SMS headers whose PDU line did not arrive in time.
+ * Returns msec until the next pending header expires, or -1 if none.
+ */
+static long long expireSmsHeaders(int firstChannel, int lastChannel) {
+    int channelID;
+    long long now = getMonotonicMsec();
+    long long left, next = -1;
+    struct ATChannels *ATch = NULL;
+
+    for (channelID = firstChannel; channelID < lastChannel; channelID++) {
+        ATch = &s_ATChannel[channelID];
+        if (ATch->s_smsHeader == NULL) continue;
+
+        left = ATch->s_smsHeaderDeadline - now;
+        if (left <= 0) {
+            RLOGE("channel%d: no PDU for \"%s\", drop it", channelID,
+                  ATch->s_smsHeader);
+            clearSmsHeader(ATch);
+        } else if (next < 0 || left < next) {
+            next = left;
+        }
+    }
+    return next;
+}
+
+/**
+ * Two-line SMS unsolicited is assembled across reads, so a late PDU line
+ * never blocks the other channels of this reader thread.
+ * Returns 1 if the current line was consumed.
+ */
+static int processSmsLine(struct ATChannels *ATch) {
+    if (ATch->s_smsHeader != NULL) {
+        if (getMonotonicMsec() < ATch->s_smsHeaderDeadline) {
+            if (ATch->s_unsolHandler != NULL) {
+                ATch->s_unsolHandler(ATch->channelID, ATch->s_smsHeader,
+                                     ATch->line);
+            }
+            clearSmsHeader(ATch);
+            return 1;
+        }
+        RLOGE("channel%d: PDU for \"%s\" timed out", ATch->channelID,
+              ATch->s_smsHeader);
+        clearSmsHeader(ATch);
+    }
+
+    if (isSMSUnsolicited(ATch->line)) {
+        ATch->s_smsHeader = strdup(ATch->line);
+        ATch->s_smsHeaderDeadline = getMonotonicMsec() + SMS_PDU_TIMEOUT_MSEC;
+        return 1;
     }
+    return 0;
 }
 
 /* assumes s_commandmutex is held */
@@ -247,7 +248,7 @@ static void processLine(struct ATChannels *ATch) {
         case NUMERIC:
             if (ATch->sp_response->p_intermediates == NULL &&
                 isdigit(ATch->line[0])) {
-                addIntermediate(ATch);
+                at_response_add_line(ATch->sp_response, ATch->line);
             } else {
                 /* either we already have an intermediate response or
                    the line doesn't begin with a digit */
@@ -257,7 +258,7 @@ static void processLine(struct ATChannels *ATch) {
         case SINGLELINE:
             if (ATch->sp_response->p_intermediates == NULL &&
                 strStartsWith(ATch->line, ATch->s_responsePrefix)) {
-                addIntermediate(ATch);
+                at_response_add_line(ATch->sp_response, ATch->line);
             } else {
                 /* we already have an intermediate response */
                 handleUnsolicited(ATch);
@@ -266,7 +267,7 @@ static void processLine(struct ATChannels *ATch) {
         case MULTILINE:
             if (strStartsWith (ATch->line, ATch->s_responsePrefix) ||
                 strchr(ATch->line, ':') == NULL) {
-                addIntermediate(ATch);
+                at_response_add_line(ATch->sp_response, ATch->line);
             } else {
                 handleUnsolicited(ATch);
             }
@@ -281,152 +282,16 @@ static void processLine(struct ATChannels *ATch) {
     pthread_mutex_unlock(&s_ATChannelMutex[ATch->channelID]);
 }
 
-/**
- * Returns a pointer to the end of the next line
- * special-cases the "> " SMS prompt
- *
- * returns NULL if there is no complete line
- */
-static char *findNextEOL(char *cur) {
-    if (cur[0] == '>' && cur[1] == ' ' && cur[2] == '\0') {
-        /* SMS prompt character...not \r terminated */
-        return cur+2;
-    }
-
-    // Find next newline
-    while (*cur != '\0' && *cur != '\r' && *cur != '\n') cur++;
-
-    return *cur == '\0' ? NULL : cur;
-}
-
-
 /**
  * Reads a line from the AT channel, returns NULL on timeout.
- * Assumes it has exclusive read access to the FD
- *
  * This line is valid only until the next call to readline
- *
- * This function exists because as of writing, android libc does not
- * have buffered stdio.
  */
 static const char *readline(struct ATChannels *ATch) {
-    ssize_t count;
-    char *p_read = NULL;
-    char *p_eol = NULL;
-    /* Add for 321528 @{ */
-    ssize_t err_count = 0;
-    /* @} */
-
-    /* this is a little odd. I use *s_ATBufferCur == 0 to
-     * mean "buffer consumed completely". If it points to a character, than
-     * the buffer continues until a \0
-     */
-    if (*ATch->s_ATBufferCur == '\0') {
-        /* empty buffer */
-        ATch->s_ATBufferCur = ATch->s_ATBuffer;
-        *ATch->s_ATBufferCur = '\0';
-        p_read = ATch->s_ATBuffer;
-    } else {   /* *s_ATBufferCur != '\0' */
-        /* there's data in the buffer from the last read */
-
-        // skip over leading newlines
-        while (*ATch->s_ATBufferCur == '\r' || *ATch->s_ATBufferCur == '\n') {
-            ATch->s_ATBufferCur++;
-        }
-
-        p_eol = findNextEOL(ATch->s_ATBufferCur);
-
-        if (p_eol == NULL) {
-            /* a partial line. move it up and prepare to read more */
-            size_t len;
-
-            len = strlen(ATch->s_ATBufferCur);
-
-            memmove(ATch->s_ATBuffer, ATch->s_ATBufferCur, len + 1);
-            p_read = ATch->s_ATBuffer + len;
-            ATch->s_ATBufferCur = ATch->s_ATBuffer;
-        }
-        /* Otherwise, (p_eol !- NULL) there is a complete line  */
-        /* that will be returned the while () loop below        */
-    }
-
-    while (p_eol == NULL) {
-        if (0 == MAX_AT_RESPONSE - (p_read - ATch->s_ATBuffer)) {
-            RLOGE("Input line exceeded buffer, realloc memory to store AT line");
-
-            ATch->s_ATBackup = (char *)realloc(ATch->s_ATBackup,
-                    ATch->s_ATBackupLenCur + strlen(ATch->s_ATBufferCur));
-            memcpy(ATch->s_ATBackup + ATch->s_ATBackupLenCur, ATch->s_ATBufferCur,
-                    strlen(ATch->s_ATBufferCur));
-            ATch->s_ATBackupLenCur += strlen(ATch->s_ATBufferCur);
-
-            /* ditch buffer and start over again */
-            ATch->s_ATBufferCur = ATch->s_ATBuffer;
-            *ATch->s_ATBufferCur = '\0';
-            p_read = ATch->s_ATBuffer;
-        }
-
-        do {
-            count = read(ATch->s_fd, p_read,
-                         MAX_AT_RESPONSE - (p_read - ATch->s_ATBuffer));
-        } while (count < 0 && errno == EINTR);
-
-        if (count > 0) {
-            AT_DUMP("<< ", p_read, count);
-
-            p_read[count] = '\0';
-
-            if (*ATch->s_ATBufferCur == '\r' && ATch->s_ATBackup != NULL) {
-                p_eol = ATch->s_ATBufferCur;
-            } else {
-                // skip over leading newlines
-                while (*ATch->s_ATBufferCur == '\r' ||
-                        *ATch->s_ATBufferCur == '\n') {
-                    ATch->s_ATBufferCur++;
-                }
-
-                p_eol = findNextEOL(ATch->s_ATBufferCur);
-            }
-            p_read += count;
-            /* Add for 321528 @{ */
-            err_count = 0;
-            /* @} */
-        } else if (count <= 0) {
-            /* read error encountered or EOF reached */
-            if (count == 0) {
-                // RLOGD("atchannel: EOF reached");
-                /* Add for 321528 @{ */
-                err_count++;
-                if (err_count > 10) {
-                    RLOGD("atchannel: EOF reached. Sleep 10s");
-                    sleep(10);
-                } else {
-                    RLOGD("atchannel: EOF reached. err_count = %zd", err_count);
-                }
-                /* @} */
-            } else {
-                // RLOGD("atchannel: read error %s", strerror(errno));
-            }
-            return NULL;
-        }
+    ATch->line = at_reader_readline(&ATch->reader);
+    if (ATch->line == NULL) {
+        return NULL;
     }
 
-    /* a full line in the buffer. Place a \0 over the \r and return */
-    *p_eol = '\0';
-    if (ATch->s_ATBackup != NULL) {
-        ATch->s_ATBackup = (char *)realloc(ATch->s_ATBackup,
-                ATch->s_ATBackupLenCur + strlen(ATch->s_ATBufferCur) + 1);
-        memcpy(ATch->s_ATBackup + ATch->s_ATBackupLenCur, ATch->s_ATBufferCur,
-                strlen(ATch->s_ATBufferCur));
-        ATch->s_ATBackupLenCur += strlen(ATch->s_ATBufferCur);
-        *(ATch->s_ATBackup + ATch->s_ATBackupLenCur) = '\0';
-
-        ATch->line = ATch->s_ATBackup;
-    } else {
-        ATch->line = ATch->s_ATBufferCur;
-    }
-    ATch->s_ATBufferCur = p_eol + 1;  /* this will always be <= p_read,
-                                         and there will be a \0 at *p_read */
     if (!ATch->nolog) {
         if (!ATch->name) {
             RLOGD("AT< %s\n", ATch->line);
@@ -476,6 +341,8 @@ static void *readerLoop(void *arg) {
     int ret;
     fd_set rfds;
     int firstChannel, lastChannel;
+    long long timeoutMsec;
+    struct timeval tv;
     RIL_SOCKET_ID socket_id = *((RIL_SOCKET_ID *)arg);
 
     int open_ATchs = s_readerThread[socket_id].openedATChs;
@@ -490,9 +357,13 @@ static void *readerLoop(void *arg) {
 
     for (;;) {
         do {
+            timeoutMsec = expireSmsHeaders(firstChannel, lastChannel);
+            tv.tv_sec = timeoutMsec / 1000;
+            tv.tv_usec = (timeoutMsec % 1000) * 1000;
             rfds = s_readerThread[socket_id].readerSet;
-            ret = select(open_ATchs + 1, &rfds, NULL, NULL, NULL);
-        } while (ret == -1 && errno == EINTR);
+            ret = select(open_ATchs + 1, &rfds, NULL, NULL,
+                         timeoutMsec < 0 ? NULL : &tv);
+        } while ((ret == -1 && errno == EINTR) || ret == 0);
         if (ret > 0) {
             for (channelID = firstChannel; channelID < lastChannel;
                   channelID++) {
@@ -506,31 +377,9 @@ static void *readerLoop(void *arg) {
                         if (ATch->line == NULL) {
                             break;
                         }
-                        if (isSMSUnsolicited(ATch->line)) {
-                            char *line1;
-                            const char *line2;
-
-                            // The scope of string returned by 'readline()'
-                            // is valid only till next call to 'readline()'
-                            // hence making a copy of line
-                            // before calling readline again.
-                            line1 = strdup(ATch->line);
-                            at_backup_free(ATch);
-                            fcntl(ATch->s_fd, F_SETFL, O_RDWR);
-                            line2 = readline(ATch);
-                            fcntl(ATch->s_fd, F_SETFL, O_RDWR | O_NONBLOCK);
-
-                            if (line2 == NULL) {
-                                free(line1);
-                                break;
-                            }
-                            if (ATch->s_unsolHandler != NULL)
-                                ATch->s_unsolHandler(channelID, line1, line2);
-                            free(line1);
-                        } else {
+                        if (!processSmsLine(ATch)) {
                             processLine(ATch);
                         }
-                        at_backup_free(ATch);
                     }
                  }
             }
@@ -734,11 +583,11 @@ struct ATChannels *at_open(int fd, int channelID, char *name,
     ATch->s_responsePrefix = NULL;
     ATch->channelID = channelID;
     ATch->s_smsPDU = NULL;
+    ATch->s_smsHeader = NULL;
     ATch->s_unsolHandler = h;
     ATch->sp_response = NULL;
     ATch->nolog = 1;
-    memset(ATch->s_ATBuffer, 0, sizeof(ATch->s_ATBuffer));
-    ATch->s_ATBufferCur = ATch->s_ATBuffer;
+    at_reader_init(&ATch->reader, fd, ATch->s_ATBuffer, MAX_AT_RESPONSE);
 
     RIL_SOCKET_ID socket_id = getSocketIdByChannelID(channelID);
 
@@ -790,6 +639,7 @@ void at_close(struct ATChannels *ATch) {
     if (ATch->name) {
         free(ATch->name);
     }
+    clearSmsHeader(ATch);
 
     ATch->s_fd = -1;
 }
@@ -818,49 +668,6 @@ void stop_reader(RIL_SOCKET_ID socket_id) {
 }
 
 
-ATResponse * at_response_new() {
-    return (ATResponse *)calloc(1, sizeof(ATResponse));
-}
-
-void at_response_free(ATResponse *p_response) {
-    ATLine *p_line;
-
-    if (p_response == NULL) return;
-
-    p_line = p_response->p_intermediates;
-
-    while (p_line != NULL) {
-        ATLine *p_toFree;
-
-        p_toFree = p_line;
-        p_line = p_line->p_next;
-
-        free(p_toFree->line);
-        free(p_toFree);
-    }
-
-    free(p_response->finalResponse);
-    free(p_response);
-}
-
-/**
- * The line reader places the intermediate responses in reverse order
- * here we flip them back
- */
-static void reverseIntermediates(struct ATChannels *ATch) {
-    ATLine *pcur, *pnext;
-
-    pcur = ATch->sp_response->p_intermediates;
-    ATch->sp_response->p_intermediates = NULL;
-
-    while (pcur != NULL) {
-        pnext = pcur->p_next;
-        pcur->p_next = ATch->sp_response->p_intermediates;
-        ATch->sp_response->p_intermediates = pcur;
-        pcur = pnext;
-    }
-}
-
 /**
  * Internal send_command implementation
  * Doesn't lock or call the timeout callback
@@ -932,7 +739,7 @@ static int at_send_command_full_nolock(struct ATChannels *ATch,
         at_response_free(ATch->sp_response);
     } else {
         /* line reader stores intermediate responses in reverse order */
-        reverseIntermediates(ATch);
+        at_response_reverse(ATch->sp_response);
         *pp_outResponse = ATch->sp_response;
     }
 
@@ -945,6 +752,38 @@ error:
     return err;
 }
 
+static bool isEmergencyLaneThread() {
+    return s_emergencyLaneStarted &&
+           pthread_equal(s_emergencyLaneTid, pthread_self()) != 0;
+}
+
+void at_emergency_lane_begin(long long arrivalMsec) {
+    s_emergencyArrivalMsec = arrivalMsec;
+}
+
+/**
+ * Commands from the emergency lane thread skip getChannel() and go to the
+ * URC channel of the SIM, which the channel pool never hands out. So an
+ * emergency ATD never waits behind a slow command such as AT+COPS or
+ * AT+CGACT holding the normal channels.
+ */
+static int acquireChannel(RIL_SOCKET_ID socket_id) {
+    if (isEmergencyLaneThread()) {
+#if defined (ANDROID_MULTI_SIM)
+        return socket_id * AT_CHANNEL_OFFSET;
+#else
+        return AT_URC;
+#endif
+    }
+    return getChannel(socket_id);
+}
+
+static void releaseChannel(int channelID) {
+    if (!isEmergencyLaneThread()) {
+        putChannel(channelID);
+    }
+}
+
 /**
  * Internal send_command implementation
  *
@@ -968,6 +807,12 @@ static int at_send_command_full(struct ATChannels *ATch,
 
     pthread_mutex_lock(&s_ATChannelMutex[ATch->channelID]);
 
+    if (isEmergencyLaneThread()) {
+        RLOGD("emergency lane: %s on channel%d, %lld ms after request arrival",
+              command, ATch->channelID,
+              getMonotonicMsec() - s_emergencyArrivalMsec);
+    }
+
     err = at_send_command_full_nolock(ATch, command, type,
                     responsePrefix, smspdu,
                     timeoutMsec, pp_outResponse);
@@ -1047,10 +892,10 @@ int at_send_command(RIL_SOCKET_ID socket_id, const char *command,
         s_psOpened[socket_id] = 1;
     }
 
-    int channelID = getChannel(socket_id);
+    int channelID = acquireChannel(socket_id);
     err = at_send_command_full(s_ATChannels[channelID], command, NO_RESULT,
                                NULL, NULL, timeoutMesc, pp_outResponse);
-    putChannel(channelID);
+    releaseChannel(channelID);
 
     return err;
 }
@@ -1067,10 +912,10 @@ int at_send_command_snvm(RIL_SOCKET_ID socket_id, const char *command,
     long long timeoutMesc = 0;
 
     timeoutMesc = getATTimeoutMesc(command);
-    int channelID = getChannel(socket_id);
+    int channelID = acquireChannel(socket_id);
     err = at_send_command_full(s_ATChannels[channelID], command, NO_RESULT,
                                responsePrefix, pdu, timeoutMesc, pp_outResponse);
-    putChannel(channelID);
+    releaseChannel(channelID);
 
     return err;
 }
@@ -1088,10 +933,10 @@ int at_send_command_singleline(RIL_SOCKET_ID socket_id,
     long long timeoutMesc = 0;
 
     timeoutMesc = getATTimeoutMesc(command);
-    int channelID = getChannel(socket_id);
+    int channelID = acquireChannel(socket_id);
     err = at_send_command_full(s_ATChannels[channelID], command, SINGLELINE,
                                responsePrefix, NULL, timeoutMesc, pp_outResponse);
-    putChannel(channelID);
+    releaseChannel(channelID);
 
     if (err == 0 && pp_outResponse != NULL
         && (*pp_outResponse)->success > 0
@@ -1118,10 +963,10 @@ int at_send_command_numeric(RIL_SOCKET_ID socket_id, const char *command,
 
     timeoutMesc = getATTimeoutMesc(command);
 
-    int channelID = getChannel(socket_id);
+    int channelID = acquireChannel(socket_id);
     err = at_send_command_full(s_ATChannels[channelID], command, NUMERIC, NULL,
                                NULL, timeoutMesc, pp_outResponse);
-    putChannel(channelID);
+    releaseChannel(channelID);
 
     if (err == 0 && pp_outResponse != NULL && (*pp_outResponse)->success > 0 &&
        (*pp_outResponse)->p_intermediates == NULL) {
@@ -1147,10 +992,10 @@ int at_send_command_sms(RIL_SOCKET_ID socket_id, const char *command,
     long long timeoutMesc = 0;
 
     timeoutMesc = getATTimeoutMesc(command);
-    int channelID = getChannel(socket_id);
+    int channelID = acquireChannel(socket_id);
     err = at_send_command_full(s_ATChannels[channelID], command, SINGLELINE,
                                responsePrefix, pdu, timeoutMesc, pp_outResponse);
-    putChannel(channelID);
+    releaseChannel(channelID);
 
     if (err == 0 && pp_outResponse != NULL && (*pp_outResponse)->success > 0 &&
         (*pp_outResponse)->p_intermediates == NULL) {
@@ -1187,10 +1032,10 @@ int at_send_command_multiline(RIL_SOCKET_ID socket_id,
         s_psOpened[socket_id] = 1;
     }
 
-    int channelID = getChannel(socket_id);
+    int channelID = acquireChannel(socket_id);
     err = at_send_command_full(s_ATChannels[channelID], command, MULTILINE,
                                responsePrefix, NULL, timeoutMesc, pp_outResponse);
-    putChannel(channelID);
+    releaseChannel(channelID);
     return err;
 }
 
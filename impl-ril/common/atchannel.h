@@ -18,6 +18,7 @@
 #define ATCHANNEL_H_
 
 #include <telephony/ril.h>
+#include "at_engine.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -41,20 +42,6 @@ typedef enum {
                     starting with a prefix */
 } ATCommandType;
 
-/** a singly-lined list of intermediate responses */
-typedef struct ATLine  {
-    struct ATLine *p_next;
-    char *line;
-} ATLine;
-
-/** Free this with at_response_free() */
-typedef struct {
-    int success;                /* true if final response indicates
-                                    success (eg "OK") */
-    char *finalResponse;        /* eg OK, ERROR */
-    ATLine *p_intermediates;    /* any intermediate responses */
-} ATResponse;
-
 /**
  * a user-provided unsolicited response handler function
  * this will be called from the reader thread, so do not block
@@ -73,9 +60,7 @@ struct ATChannels {
     int nolog;
 
     char s_ATBuffer[MAX_AT_RESPONSE+1];
-    char *s_ATBufferCur;
-    char *s_ATBackup;
-    int s_ATBackupLenCur;
+    ATLineReader reader;
     /* current line */
     char *line;
 
@@ -86,6 +71,10 @@ struct ATChannels {
     char *p_read;
     char *p_eol;
 
+    /* first line of a two-line SMS unsolicited, waiting for its PDU line */
+    char *s_smsHeader;
+    long long s_smsHeaderDeadline;  /* CLOCK_MONOTONIC, in msec */
+
     /* Handler */
     ATUnsolHandler s_unsolHandler;
 };
@@ -153,13 +142,13 @@ typedef struct {
 #define AT_ERROR_MODEM_BLOCKED      -8
 
 extern bool s_CModChgState[SIM_COUNT];
+extern pthread_t s_emergencyLaneTid;
+extern bool s_emergencyLaneStarted;
 extern pthread_mutex_t s_CModChgMutex[MAX_AT_CHANNELS];
 extern pthread_cond_t s_CModChgCond[MAX_AT_CHANNELS];
 extern RIL_SOCKET_ID getSocketIdByChannelID(int channelID);
 
-ATResponse * at_response_new();
-int isFinalResponseError(const char *line);
-int isFinalResponseSuccess(const char *line);
+long long getMonotonicMsec();
 
 void init_channels(RIL_SOCKET_ID socket_id);
 void stop_reader(RIL_SOCKET_ID socket_id);
@@ -179,6 +168,10 @@ void at_set_on_timeout(void (*onTimeout)(RIL_SOCKET_ID socket_id));
    channel is already closed */
 void at_set_on_reader_closed(void (*onClose)(RIL_SOCKET_ID socket_id));
 
+/* Called on the emergency lane thread before each request it processes,
+   arrivalMsec is getMonotonicMsec() when the request reached onRequest */
+void at_emergency_lane_begin(long long arrivalMsec);
+
 int at_send_command_singleline(RIL_SOCKET_ID socket_id,
                                const char *command,
                                const char *responsePrefix,
@@ -211,7 +204,6 @@ int at_send_command_snvm(RIL_SOCKET_ID socket_id, const char *command,
                          const char *pdu, const char *responsePrefix,
                          ATResponse **pp_outResponse);
 
-void at_response_free(ATResponse *p_response);
 
 AT_CME_Error at_get_cme_error(const ATResponse *p_response);
 
@@ -4,6 +4,8 @@
 
 #define LOG_TAG "RIL"
 
+#include <poll.h>
+
 #include "impl_ril.h"
 #include "ril_network.h"
 #include "channel_controller.h"
@@ -78,23 +80,245 @@ const cmd_table s_ATTimeoutTable[] = {
 int s_fdModemBlockRead;
 int s_fdModemBlockWrite;
 ModemState s_modemState = MODEM_OFFLINE;
+long long s_modemDownMsec = 0;  // when the last assert/reset/block was seen
 extern int s_fdReaderLoopWakeupWrite[SIM_COUNT];
 extern pthread_mutex_t s_radioStateMutex[SIM_COUNT];
 extern pthread_cond_t s_radioStateCond[SIM_COUNT];
 extern ReaderThread s_readerThread[SIM_COUNT];
 
 static int doHandShake();
+static int tryHandshake();
 static int openModemDev(char *path);
 static int sendHandshakeCmd(int stty_fd, char *atCmd, char *path);
 
+typedef enum {
+    MODEMD_MSG_UNKNOWN,
+    MODEMD_MSG_ASSERT,
+    MODEMD_MSG_BLOCKED,
+    MODEMD_MSG_RESET,
+    MODEMD_MSG_ALIVE,
+    MODEMD_MSG_CP2_ASSERT,  // "P-ARM Modem Assert", RIL keeps running
+} ModemdMessage;
+
+#define MODEMD_RECONNECT_MIN_MSEC   20
+#define MODEMD_RECONNECT_MAX_MSEC   500
+
+/* the handshake command is resent on every timeout, which doubles up to
+ * the max, and given up after HANDSHAKE_MAX_ATTEMPTS (~10 s in total) */
+#define HANDSHAKE_TIMEOUT_MIN_MSEC  100
+#define HANDSHAKE_TIMEOUT_MAX_MSEC  2000
+#define HANDSHAKE_MAX_ATTEMPTS      8
+
+/* a handshake that got no answer is started over with backoff from the
+ * detectModemState loop, so modemd is still read in between. Once
+ * HANDSHAKE_RETRY_TOTAL_MSEC have passed, modemd is told the modem is
+ * blocked */
+#define HANDSHAKE_RETRY_MIN_MSEC    1000
+#define HANDSHAKE_RETRY_MAX_MSEC    8000
+#define HANDSHAKE_RETRY_TOTAL_MSEC  60000
+
+#define HANDSHAKE_OK                0
+#define HANDSHAKE_NO_ANSWER         -1  // no device or no answer, retry
+#define HANDSHAKE_ERROR             -2  // modem answered ERROR, don't retry
+
+static long long s_handshakeStartMsec = 0;
+static long long s_handshakeRetryMsec = 0;  // when to retry, 0 if not pending
+static int s_handshakeRetryDelayMsec = HANDSHAKE_RETRY_MIN_MSEC;
+
+static ModemdMessage classifyModemdMessage(const char *msg) {
+    if (strstr(msg, "Modem Blocked")) {
+        return MODEMD_MSG_BLOCKED;
+    } else if (strstr(msg, "P-ARM Modem Assert")) {
+        return MODEMD_MSG_CP2_ASSERT;
+    } else if (strstr(msg, "Modem Assert")) {
+        return MODEMD_MSG_ASSERT;
+    } else if (strstr(msg, "Modem Reset")) {
+        return MODEMD_MSG_RESET;
+    } else if (strstr(msg, "Modem Alive") || strstr(msg, "Modem State: Alive")) {
+        return MODEMD_MSG_ALIVE;
+    }
+    return MODEMD_MSG_UNKNOWN;
+}
+
+/* kicks the reader loops out of select, onlyOpened skips closed readers */
+static void wakeupReaderLoops(bool onlyOpened) {
+    int simId;
+
+    for (simId = 0; simId < SIM_COUNT; simId++) {
+        if (onlyOpened && s_readerThread[simId].readerClosed != 0) {
+            continue;
+        }
+        write(s_fdReaderLoopWakeupWrite[simId], " ", 1);
+    }
+}
+
+static bool anyReaderOpened() {
+    int simId;
+
+    for (simId = 0; simId < SIM_COUNT; simId++) {
+        if (s_readerThread[simId].readerClosed == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void markModemOffline() {
+    if (s_modemState == MODEM_ALIVE) {
+        s_modemDownMsec = getMonotonicMsec();
+    }
+    s_modemState = MODEM_OFFLINE;
+}
+
+static void reportModemState(RIL_ModemDetailStatus modemState, char *msg) {
+    RIL_ModemStatusInfo responseMs;
+
+    responseMs.modemState = modemState;
+    responseMs.assertInfo = msg;
+    RIL_SOCKET_ID socket_id = RIL_SOCKET_1;
+    RIL_onUnsolicitedResponse(RIL_EXT_UNSOL_MODEM_STATE_CHANGED,
+                              &responseMs, sizeof(RIL_ModemStatusInfo), socket_id);
+}
+
+static void handleModemdMessage(char *msg) {
+    ModemdMessage type = classifyModemdMessage(msg);
+    RIL_ModemDetailStatus modemState;
+
+    RLOGE("%s", msg);
+    if (type == MODEMD_MSG_ASSERT || type == MODEMD_MSG_BLOCKED ||
+            type == MODEMD_MSG_RESET) {
+        s_handshakeRetryMsec = 0;
+    }
+    switch (type) {
+        case MODEMD_MSG_ASSERT:
+        case MODEMD_MSG_BLOCKED:
+            /* set modem assert for RIL to unlock pin */
+            property_set(MODEM_ASSERT_PROP, "1,1");
+            markModemOffline();
+            RLOGE("Modem Assert or Blocked, Info readerLoop to get out of select");
+            wakeupReaderLoops(false);
+            modemState = strstr(msg, "Modem Blocked") ?
+                                 MODEM_STATUS_BLOCKED : MODEM_STATUS_ASSERT;
+            break;
+
+        case MODEMD_MSG_RESET:
+            /* set modem assert for RIL to unlock pin */
+            property_set(MODEM_ASSERT_PROP, "1,1");
+            if (anyReaderOpened()) {
+                markModemOffline();
+                RLOGE("Modem Reset, Info readerLoop to get out of select");
+                wakeupReaderLoops(true);
+            }
+            modemState = MODEM_STATUS_RESET;
+            break;
+
+        case MODEMD_MSG_ALIVE:
+            if (s_modemState == MODEM_ALIVE) {
+                return;
+            }
+
+            RLOGD("Modem Alive, do handshake first");
+            /* a repeated Alive retries at once, but doesn't extend the limit */
+            if (s_handshakeRetryMsec == 0) {
+                s_handshakeStartMsec = getMonotonicMsec();
+                s_handshakeRetryDelayMsec = HANDSHAKE_RETRY_MIN_MSEC;
+            }
+            if (tryHandshake() < 0) {
+                return;
+            }
+            modemState = MODEM_STATUS_ALIVE;
+            break;
+
+        default:
+            RLOGE("unknown modem state");
+            return;
+    }
+    reportModemState(modemState, msg);
+}
+
+/**
+ * Drains the modemd socket. Messages are '\0' terminated, so several
+ * messages arriving in one read are taken apart instead of being matched
+ * as one string. Newlines are not separators, assert info spans lines.
+ * An unterminated tail is kept in buf, *len bytes, until the rest of it
+ * arrives with a later read. It is taken as a whole message only when
+ * modemd closes the connection or it fills buf.
+ * Returns -1 if modemd closed the connection.
+ */
+static int readModemdMessages(int fd, char *buf, size_t size, size_t *len) {
+    size_t start, end;
+    ssize_t count;
+
+    for (;;) {
+        do {
+            count = read(fd, buf + *len, size - 1 - *len);
+        } while (count < 0 && errno == EINTR);
+
+        if (count == 0 || (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            if (*len > 0) {
+                buf[*len] = '\0';
+                handleModemdMessage(buf);
+                *len = 0;
+            }
+            return -1;
+        }
+        if (count < 0) {
+            return 0;  // socket drained, keep the tail for the next poll
+        }
+        *len += count;
+
+        start = 0;
+        for (end = 0; end < *len; end++) {
+            if (buf[end] == '\0') {
+                if (end > start) {
+                    handleModemdMessage(buf + start);
+                }
+                start = end + 1;
+            }
+        }
+        *len -= start;
+        memmove(buf, buf + start, *len);
+
+        if (*len == size - 1) {
+            /* a message too long to ever terminate */
+            buf[*len] = '\0';
+            handleModemdMessage(buf);
+            *len = 0;
+        }
+    }
+}
+
+static int connectModemd(const char *socketName) {
+    int delayMsec = MODEMD_RECONNECT_MIN_MSEC;
+    int fd = socket_local_client(socketName,
+            ANDROID_SOCKET_NAMESPACE_ABSTRACT, SOCK_STREAM);
+
+    /* abstract sockets can't be watched, back off instead of a fixed sleep */
+    while (fd < 0) {
+        usleep(delayMsec * 1000);
+        if (delayMsec < MODEMD_RECONNECT_MAX_MSEC) {
+            delayMsec *= 2;
+        }
+        fd = socket_local_client(socketName,
+                ANDROID_SOCKET_NAMESPACE_ABSTRACT, SOCK_STREAM);
+    }
+    RLOGD("Connect to modemd socket success!");
+
+    if (fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+        RLOGE("fcntl on fdModemd failed");
+    }
+    return fd;
+}
+
 void *detectModemState() {
-    int ret = -1;
     int num = 0;
     int filedes[2];
-    int nfds = 0;
     int fdModemd = -1;
-    fd_set rfds, readFds;
+    int timeoutMsec = -1;
+    size_t len = 0;
+    struct pollfd pfds[2];
     char buf[ARRAY_SIZE * 5] = {0};
+    char blockBuf[ARRAY_SIZE] = {0};
     const char socketName[ARRAY_SIZE] = "modemd";
 
     s_ATTableSize = NUM_ELEMS(s_ATTimeoutTable);
@@ -109,120 +333,45 @@ void *detectModemState() {
         RLOGE("fcntl on s_fdModemBlockRead failed");
     }
 
-    FD_SET(s_fdModemBlockRead, &readFds);
-    if (s_fdModemBlockRead >= nfds) {
-        nfds = s_fdModemBlockRead + 1;
-    }
-
-RECONNECT:
-    {
-        int fd = socket_local_client(socketName,
-                ANDROID_SOCKET_NAMESPACE_ABSTRACT, SOCK_STREAM);
-        while (fd < 0) {
-            usleep(500000);
-            fd = socket_local_client(socketName,
-                    ANDROID_SOCKET_NAMESPACE_ABSTRACT, SOCK_STREAM);
-        }
-        RLOGD("Connect to modemd socket success!");
-
-        if (fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
-            RLOGE("fcntl on fdModemd failed");
-        }
-        FD_SET(fd, &readFds);
-        if (fd >= nfds) {
-            nfds = fd + 1;
-        }
-
-        fdModemd = fd;
-    }
+    fdModemd = connectModemd(socketName);
 
     for (;;) {
+        pfds[0].fd = s_fdModemBlockRead;
+        pfds[0].events = POLLIN;
+        pfds[1].fd = fdModemd;
+        pfds[1].events = POLLIN;
+        timeoutMsec = -1;
+        if (s_handshakeRetryMsec > 0) {
+            timeoutMsec = s_handshakeRetryMsec - getMonotonicMsec();
+            if (timeoutMsec < 0) {
+                timeoutMsec = 0;
+            }
+        }
         do {
-            memcpy(&rfds, &readFds, sizeof(fd_set));
-            num = select(nfds, &rfds, NULL, NULL, NULL);
+            num = poll(pfds, NUM_ELEMS(pfds), timeoutMsec);
         } while (num == -1 && errno == EINTR);
 
-        if (num > 0) {
-            if (FD_ISSET(s_fdModemBlockRead, &rfds)) {  // from at_send_command in RIL
-                memset(buf, 0, sizeof(buf));
-                read(s_fdModemBlockRead, buf, sizeof(buf));
-                RLOGE("Modem blocked, info modemd");
-                if (fdModemd >= 0) {
-                    int ret = write(fdModemd, "Modem Blocked",
-                            sizeof("Modem Blocked"));
-                    RLOGE("Write %d bytes to client: %d modemd is blocked",
-                          ret, fdModemd);
-                } else {
-                    RLOGE("Failed to connect to modemd, reconnect");
-                    goto RECONNECT;
-                }
+        if (num == 0 && s_handshakeRetryMsec > 0) {
+            if (tryHandshake() == 0) {
+                reportModemState(MODEM_STATUS_ALIVE, "Modem Alive");
             }
-            if (FD_ISSET(fdModemd, &rfds)) {  // from modemd
-                RIL_ModemStatusInfo responseMs;
-                memset(buf, 0, sizeof(buf));
-                int readNum = read(fdModemd, buf, sizeof(buf));
-                RLOGE("%s", buf);
-                if (readNum <= 0) {
-                    close(fdModemd);
-                    goto RECONNECT;
-                }
-                /* RIL don't stop when cm4 assert, which notifies "P-ARM Modem Assert" */
-                if (strstr(buf, "Modem Blocked") ||
-                    (strstr(buf, "Modem Assert") && !strstr(buf, "P-ARM Modem Assert"))) {
-                    /* set modem assert for RIL to unlock pin */
-                    property_set(MODEM_ASSERT_PROP, "1,1");
-                    s_modemState = MODEM_OFFLINE;
-                    RLOGE("Modem Assert or Blocked, Info readerLoop to get out of select");
-                    write(s_fdReaderLoopWakeupWrite[RIL_SOCKET_1], " ", 1);
-
-#if (SIM_COUNT >= 2)
-                    write(s_fdReaderLoopWakeupWrite[RIL_SOCKET_2], " ", 1);
-#endif
-                    responseMs.modemState = strstr(buf, "Modem Blocked") ?
-                                                   MODEM_STATUS_BLOCKED : MODEM_STATUS_ASSERT;
-                } else if (strstr(buf, "Modem Reset")) {
-                    /* set modem assert for RIL to unlock pin */
-                    property_set(MODEM_ASSERT_PROP, "1,1");
-                    if (s_readerThread[RIL_SOCKET_1].readerClosed == 0) {
-                        s_modemState = MODEM_OFFLINE;
-                        RLOGE("Modem Reset, Info readerLoop to get out of select");
-                        write(s_fdReaderLoopWakeupWrite[RIL_SOCKET_1], " ", 1);
-                    }
-#if (SIM_COUNT >= 2)
-                    if (s_readerThread[RIL_SOCKET_2].readerClosed == 0) {
-                        write(s_fdReaderLoopWakeupWrite[RIL_SOCKET_2], " ", 1);
-                    }
-#endif
-                    responseMs.modemState = MODEM_STATUS_RESET;
-                } else if (strstr(buf, "Modem Alive") ||
-                        strstr(buf, "Modem State: Alive")) {
-                    if (s_modemState == MODEM_ALIVE) {
-                        continue;
-                    }
-
-                    RLOGD("Modem Alive, do handshake first");
-                    ret = doHandShake();
-                    if (ret < 0) {
-                        RLOGE("Failed to handshake with modem");
-                        s_modemState = MODEM_OFFLINE;
-                        continue;
-                    }
-
-                    for (int simCount = 0; simCount < SIM_COUNT; simCount++) {
-                        pthread_mutex_lock(&s_radioStateMutex[simCount]);
-                        s_modemState = MODEM_ALIVE;
-                        pthread_cond_broadcast(&s_radioStateCond[simCount]);
-                        pthread_mutex_unlock(&s_radioStateMutex[simCount]);
-                    }
-                    responseMs.modemState = MODEM_STATUS_ALIVE;
-                } else {
-                    RLOGE("unknown modem state");
-                    continue;
-                }
-                responseMs.assertInfo = buf;
-                RIL_SOCKET_ID socket_id = RIL_SOCKET_1;
-                RIL_onUnsolicitedResponse(RIL_EXT_UNSOL_MODEM_STATE_CHANGED,
-                                          &responseMs, sizeof(RIL_ModemStatusInfo), socket_id);
+            continue;
+        }
+        if (num <= 0) {
+            continue;
+        }
+        if (pfds[0].revents & POLLIN) {  // from at_send_command in RIL
+            read(s_fdModemBlockRead, blockBuf, sizeof(blockBuf));
+            RLOGE("Modem blocked, info modemd");
+            int ret = write(fdModemd, "Modem Blocked", sizeof("Modem Blocked"));
+            RLOGE("Write %d bytes to client: %d modemd is blocked", ret, fdModemd);
+        }
+        if (pfds[1].revents & (POLLIN | POLLHUP | POLLERR)) {  // from modemd
+            if (readModemdMessages(fdModemd, buf, sizeof(buf), &len) < 0) {
+                RLOGE("modemd closed the connection, reconnect");
+                close(fdModemd);
+                fdModemd = connectModemd(socketName);
+                len = 0;
             }
         }
     }
@@ -250,68 +399,81 @@ static int openModemDev(char *path) {
 /* send specified AT string */
 static int sendHandshakeCmd(int stty_fd, char *atCmd, char *path) {
     int ret = -1, err = -1;
-    int count = 0, length = 0;
+    int count = 0, length = 0, used = 0;
+    int attempt = 0;
+    int timeoutMsec = HANDSHAKE_TIMEOUT_MIN_MSEC;
     char buffer[ARRAY_SIZE] = {0};
-    fd_set rfds;
-    struct timeval timeout;
+    struct pollfd pfd;
 
     if (atCmd == NULL) {
         RLOGE("AT command is NULL");
-        ret = -1;
+        ret = HANDSHAKE_ERROR;
         goto exit;
     }
 
     RLOGD("write %s to %s", atCmd, path);
     length = strlen(atCmd);
-    for (;;) {
+    pfd.fd = stty_fd;
+    pfd.events = POLLIN;
+    for (attempt = 1; attempt <= HANDSHAKE_MAX_ATTEMPTS; attempt++) {
         err = write(stty_fd, atCmd, length);
         if (err != length) {
-            RLOGE("write error length = %d  ret = %d\n", length, ret);
-            ret = -1;
+            RLOGE("write error length = %d  ret = %d\n", length, err);
+            ret = HANDSHAKE_NO_ANSWER;
             goto exit;
         }
+        used = 0;
+        memset(buffer, 0, sizeof(buffer));
 
-WAIT_RESPOSE:
-        timeout.tv_sec = 1;
-        timeout.tv_usec = 0;
-        FD_ZERO(&rfds);
-        FD_SET(stty_fd, &rfds);
-
-        err = select(stty_fd + 1, &rfds, NULL, NULL, &timeout);
-        if (err < 0) {
-            RLOGE("select error: %s", strerror(errno));
-            if (errno == EINTR || errno == EAGAIN) {
-                continue;
-            } else {
-                ret = -1;
+        for (;;) {
+            err = poll(&pfd, 1, timeoutMsec);
+            if (err < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                RLOGE("poll error: %s", strerror(errno));
+                ret = HANDSHAKE_NO_ANSWER;
                 goto exit;
+            } else if (err == 0) {
+                RLOGE("%s timeout after %d ms, attempt %d", atCmd,
+                      timeoutMsec, attempt);
+                break;
             }
-        } else if (err == 0) {
-            RLOGE("select timeout");
-            continue;
-        } else {
-            memset(buffer, 0, sizeof(buffer));
-            count = read(stty_fd, buffer, sizeof(buffer) - 1);
+
+            /* a response may come in pieces, keep what was read so far */
+            if (used >= (int)sizeof(buffer) - 1) {
+                used = 0;
+                memset(buffer, 0, sizeof(buffer));
+            }
+            count = read(stty_fd, buffer + used, sizeof(buffer) - 1 - used);
             if (count <= 0) {
+                if (count < 0 && (errno == EINTR || errno == EAGAIN)) {
+                    continue;
+                }
                 RLOGE("read %d return %d, error: %s", stty_fd, count,
                             strerror(errno));
-                continue;
+                break;
             }
+            used += count;
             RLOGD("read response %s", buffer);
             if (strstr(buffer, "OK")) {
-                ret = 0;
-                break;
+                ret = HANDSHAKE_OK;
+                goto exit;
             } else if (strstr(buffer, "ERROR")) {
                 RLOGE("wrong modem state, exit!");
-                ret = -1;
+                ret = HANDSHAKE_ERROR;
                 goto exit;
-            } else {
-                // go on wait
-                RLOGD("do nothing, go on wait!");
-                goto WAIT_RESPOSE;
             }
+            // go on wait
+        }
+
+        if (timeoutMsec < HANDSHAKE_TIMEOUT_MAX_MSEC) {
+            timeoutMsec *= 2;
         }
     }
+    RLOGE("no response to %s after %d attempts", atCmd,
+          HANDSHAKE_MAX_ATTEMPTS);
+    ret = HANDSHAKE_NO_ANSWER;
 
 exit:
     return ret;
@@ -319,17 +481,17 @@ exit:
 
 static int doHandShake() {
     int fd = -1;
-    int ret = 0;
+    int ret = HANDSHAKE_OK;
     char cmd[AT_COMMAND_LEN] = {0};
     char path[ARRAY_SIZE] = {0};
     char modemDev[PROPERTY_VALUE_MAX] = {0};
 
-    property_get(MODEM_TTY_PROP, modemDev, "/dev/sdiomux");
+    getCachedProp(MODEM_TTY_PROP, modemDev, "/dev/sdiomux");
     snprintf(path, sizeof(path), "%s1", modemDev);
     RLOGD("open stty dev: %s", path);
     fd = openModemDev(path);
     if (fd < 0) {
-        ret = -1;
+        ret = HANDSHAKE_NO_ANSWER;
         RLOGE("Failed to open %s", path);
         goto exit;
     }
@@ -342,15 +504,15 @@ static int doHandShake() {
     snprintf(cmd, sizeof(cmd), "AT\r");
 #endif
 
-    if (sendHandshakeCmd(fd, cmd, path) != 0) {
-        ret = -2;
+    ret = sendHandshakeCmd(fd, cmd, path);
+    if (ret != HANDSHAKE_OK) {
         RLOGE("Failed to write %s to %s", cmd, path);
         goto exit;
     }
 
     snprintf(cmd, sizeof(cmd), "AT+CMUX=0\r");
-    if (sendHandshakeCmd(fd, cmd, path) != 0) {
-        ret = -2;
+    ret = sendHandshakeCmd(fd, cmd, path);
+    if (ret != HANDSHAKE_OK) {
         RLOGE("Failed to write %s to %s", cmd, path);
         goto exit;
     }
@@ -362,6 +524,51 @@ exit:
     return ret;
 }
 
+/**
+ * Runs one handshake round. Returns 0 once the modem is alive. On a hard
+ * ERROR the modem stays offline until modemd's next "Modem Alive". With
+ * no answer a retry is scheduled for the detectModemState loop, and after
+ * HANDSHAKE_RETRY_TOTAL_MSEC modemd is told the modem is blocked instead.
+ */
+static int tryHandshake() {
+    int ret = doHandShake();
+    long long now = getMonotonicMsec();
+
+    s_handshakeRetryMsec = 0;
+    if (ret == HANDSHAKE_OK) {
+        if (s_modemDownMsec > 0) {
+            RLOGD("recovery: modem alive and handshaked %lld ms after going down",
+                  now - s_modemDownMsec);
+        }
+        for (int simCount = 0; simCount < SIM_COUNT; simCount++) {
+            pthread_mutex_lock(&s_radioStateMutex[simCount]);
+            s_modemState = MODEM_ALIVE;
+            pthread_cond_broadcast(&s_radioStateCond[simCount]);
+            pthread_mutex_unlock(&s_radioStateMutex[simCount]);
+        }
+        return 0;
+    }
+
+    s_modemState = MODEM_OFFLINE;
+    if (ret == HANDSHAKE_ERROR) {
+        RLOGE("Failed to handshake with modem, wait for next Modem Alive");
+    } else if (now - s_handshakeStartMsec + s_handshakeRetryDelayMsec >
+            HANDSHAKE_RETRY_TOTAL_MSEC) {
+        RLOGE("no handshake answer for %lld ms, info modemd",
+              now - s_handshakeStartMsec);
+        /* detectModemState writes "Modem Blocked" to modemd for this */
+        write(s_fdModemBlockWrite, " ", 1);
+    } else {
+        RLOGE("handshake got no answer, retry in %d ms",
+              s_handshakeRetryDelayMsec);
+        s_handshakeRetryMsec = now + s_handshakeRetryDelayMsec;
+        if (s_handshakeRetryDelayMsec < HANDSHAKE_RETRY_MAX_MSEC) {
+            s_handshakeRetryDelayMsec *= 2;
+        }
+    }
+    return -1;
+}
+
 /**
  * Returns 1 if found, 0 otherwise. needle must be null-terminated.
  * strstr might not work because WebBox sends garbage before the first OKread
@@ -35,6 +35,7 @@ extern int s_ATTableSize;
 extern int s_fdModemBlockWrite;
 extern const cmd_table s_ATTimeoutTable[];
 extern ModemState s_modemState;
+extern long long s_modemDownMsec;
 
 void *detectModemState();
 void *signal_process();
@@ -0,0 +1,98 @@
+/**
+ * codec.c --- hex and UCS2 conversion functions implementation
+ *
+ * Copyright (C) 2019 UNISOC Technologies Co.,Ltd.
+ */
+
+#include <stddef.h>
+
+#include "codec.h"
+
+static const char s_hexDigits[] = "0123456789ABCDEF";
+
+/* value + 1 of each hex char, 0 for anything else */
+static const uint8_t s_hexValues[256] = {
+    ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,
+    ['5'] = 6,  ['6'] = 7,  ['7'] = 8,  ['8'] = 9,  ['9'] = 10,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+};
+
+int hexToBin(const char *hex, int length, uint8_t *bin) {
+    const uint8_t *src = (const uint8_t *)hex;
+    uint8_t high, low;
+    int i;
+
+    if (hex == NULL || bin == NULL || length < 0 || length % 2 != 0) {
+        return -1;
+    }
+    for (i = 0; i < length / 2; i++) {
+        high = s_hexValues[*src++];
+        low = s_hexValues[*src++];
+        if (high == 0 || low == 0) return -1;
+        bin[i] = (uint8_t)(((high - 1) << 4) | (low - 1));
+    }
+    return i;
+}
+
+char *binToHex(const uint8_t *bin, int length, char *hex) {
+    int i;
+
+    for (i = 0; i < length; i++) {
+        *hex++ = s_hexDigits[bin[i] >> 4];
+        *hex++ = s_hexDigits[bin[i] & 0x0F];
+    }
+    *hex = '\0';
+    return hex;
+}
+
+int ucs2ToUtf8(const uint8_t *ucs2, int length, char *utf8, int size) {
+    uint8_t *dst = (uint8_t *)utf8;
+    uint32_t c, low;
+    int i = 0, n = 0, need;
+
+    if (utf8 == NULL || size <= 0) return 0;
+
+    while (i + 1 < length) {
+        c = (ucs2[i] << 8) | ucs2[i + 1];
+        i += 2;
+
+        /* ASCII is the common case of USSD and alpha tags */
+        if (c < 0x80) {
+            if (n + 1 >= size) break;
+            dst[n++] = (uint8_t)c;
+            continue;
+        }
+
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < length) {
+            low = (ucs2[i] << 8) | ucs2[i + 1];
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+        }
+        if (c >= 0xD800 && c <= 0xDFFF) {
+            c = 0xFFFD;  /* unpaired surrogate */
+        }
+
+        need = c < 0x800 ? 2 : (c < 0x10000 ? 3 : 4);
+        if (n + need >= size) break;
+        switch (need) {
+            case 2:
+                dst[n++] = (uint8_t)(0xC0 | (c >> 6));
+                break;
+            case 3:
+                dst[n++] = (uint8_t)(0xE0 | (c >> 12));
+                dst[n++] = (uint8_t)(0x80 | ((c >> 6) & 0x3F));
+                break;
+            default:
+                dst[n++] = (uint8_t)(0xF0 | (c >> 18));
+                dst[n++] = (uint8_t)(0x80 | ((c >> 12) & 0x3F));
+                dst[n++] = (uint8_t)(0x80 | ((c >> 6) & 0x3F));
+                break;
+        }
+        dst[n++] = (uint8_t)(0x80 | (c & 0x3F));
+    }
+    dst[n] = '\0';
+    return n;
+}
@@ -0,0 +1,31 @@
+/**
+ * codec.h --- hex and UCS2 conversion functions declaration
+ *
+ * Copyright (C) 2019 UNISOC Technologies Co.,Ltd.
+ */
+
+#ifndef CODEC_H_
+#define CODEC_H_
+
+#include <stdint.h>
+
+/**
+ * Converts length hex chars to bytes.
+ * Returns number of bytes written, or -1 on odd length or invalid char.
+ */
+int hexToBin(const char *hex, int length, uint8_t *bin);
+
+/**
+ * Converts length bytes to upper case hex chars and terminates them.
+ * Returns pointer to the terminating '\0', hex must hold 2 * length + 1.
+ */
+char *binToHex(const uint8_t *bin, int length, char *hex);
+
+/**
+ * Converts big endian UCS2 (surrogate pairs allowed) to UTF-8.
+ * utf8 is always terminated, output is cut at a character boundary if
+ * size is not enough. Returns number of bytes written, without '\0'.
+ */
+int ucs2ToUtf8(const uint8_t *ucs2, int length, char *utf8, int size);
+
+#endif  // CODEC_H_
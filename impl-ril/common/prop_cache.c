@@ -0,0 +1,183 @@
+/**
+ * prop_cache.c --- cached access to system properties read on request paths
+ *
+ * Copyright (C) 2019 UNISOC Technologies Co.,Ltd.
+ */
+
+#define LOG_TAG "RIL"
+
+#include "impl_ril.h"
+#include "prop_cache.h"
+
+#define PROP_CACHE_SIZE     64
+
+typedef struct {
+    char *key;
+    unsigned int hash;
+    bool loaded;
+    const prop_info *pi;        /* NULL while the property doesn't exist */
+    uint32_t serial;            /* serial of pi when value was read */
+    uint32_t areaSerial;        /* area serial when the key was not found */
+    char value[PROPERTY_VALUE_MAX];
+    char split[PROPERTY_VALUE_MAX];
+    const char *simValue[RIL_SOCKET_NUM];  /* point into split */
+} PropCacheEntry;
+
+static PropCacheEntry s_propCache[PROP_CACHE_SIZE];
+static int s_propCacheCount = 0;
+static pthread_mutex_t s_propCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int hashKey(const char *key) {
+    unsigned int hash = 5381;
+
+    while (*key != '\0') {
+        hash = hash * 33 + (unsigned char)*key++;
+    }
+    return hash;
+}
+
+/* returns NULL once the table is full, callers then go to the property area */
+static PropCacheEntry *findEntry(const char *key) {
+    int i = 0;
+    unsigned int hash = hashKey(key);
+    PropCacheEntry *entry = NULL;
+
+    for (i = 0; i < s_propCacheCount; i++) {
+        if (s_propCache[i].hash == hash && !strcmp(s_propCache[i].key, key)) {
+            return &s_propCache[i];
+        }
+    }
+    if (s_propCacheCount >= PROP_CACHE_SIZE) {
+        RLOGE("property cache full, %s is read uncached", key);
+        return NULL;
+    }
+
+    entry = &s_propCache[s_propCacheCount];
+    entry->key = strdup(key);
+    if (entry->key == NULL) {
+        return NULL;
+    }
+    entry->hash = hash;
+    s_propCacheCount++;
+    return entry;
+}
+
+static void onPropRead(void *cookie, const char *name, const char *value,
+                       uint32_t serial) {
+    PropCacheEntry *entry = (PropCacheEntry *)cookie;
+    RIL_UNUSED_PARM(name);
+
+    snprintf(entry->value, sizeof(entry->value), "%s", value);
+    entry->serial = serial;
+}
+
+static void splitSimValues(PropCacheEntry *entry) {
+    int simId = 0;
+    char *buf = entry->split;
+
+    memcpy(entry->split, entry->value, sizeof(entry->split));
+    for (simId = 0; simId < RIL_SOCKET_NUM; simId++) {
+        entry->simValue[simId] = strsep(&buf, ",");
+    }
+}
+
+/* brings entry up to date with the property area */
+static void refreshEntry(PropCacheEntry *entry) {
+    uint32_t areaSerial = 0;
+
+    if (entry->pi == NULL) {
+        /* the area serial moves whenever any property is added or set */
+        areaSerial = __system_property_area_serial();
+        if (entry->loaded && areaSerial == entry->areaSerial) {
+            return;
+        }
+        entry->pi = __system_property_find(entry->key);
+        if (entry->pi == NULL) {
+            entry->areaSerial = areaSerial;
+            entry->value[0] = '\0';
+            splitSimValues(entry);
+            entry->loaded = true;
+            return;
+        }
+    } else if (entry->loaded &&
+            __system_property_serial(entry->pi) == entry->serial) {
+        return;
+    }
+
+    __system_property_read_callback(entry->pi, onPropRead, entry);
+    splitSimValues(entry);
+    entry->loaded = true;
+}
+
+int getCachedProp(const char *key, char *value, const char *defaultValue) {
+    int len = 0;
+    PropCacheEntry *entry = NULL;
+
+    pthread_mutex_lock(&s_propCacheMutex);
+    entry = findEntry(key);
+    if (entry == NULL) {
+        pthread_mutex_unlock(&s_propCacheMutex);
+        return property_get(key, value, defaultValue);
+    }
+    refreshEntry(entry);
+    len = strlen(entry->value);
+    memcpy(value, entry->value, len + 1);
+    pthread_mutex_unlock(&s_propCacheMutex);
+
+    if (len == 0 && defaultValue != NULL) {
+        snprintf(value, PROPERTY_VALUE_MAX, "%s", defaultValue);
+        len = strlen(value);
+    }
+    return len;
+}
+
+void getCachedSimProp(RIL_SOCKET_ID socket_id, const char *key, char *value,
+                      const char *defaultValue) {
+    const char *simValue = NULL;
+    PropCacheEntry *entry = NULL;
+
+    if (value == NULL) {
+        RLOGE("The memory to save prop is NULL!");
+        return;
+    }
+
+    pthread_mutex_lock(&s_propCacheMutex);
+    entry = findEntry(key);
+    if (entry == NULL) {
+        pthread_mutex_unlock(&s_propCacheMutex);
+        getProperty(socket_id, key, value, defaultValue);
+        return;
+    }
+    refreshEntry(entry);
+    if (socket_id >= RIL_SOCKET_1 && socket_id < RIL_SOCKET_NUM) {
+        simValue = entry->simValue[socket_id];
+    }
+    if (simValue != NULL && strcmp(simValue, "")) {
+        memcpy(value, simValue, strlen(simValue) + 1);
+        pthread_mutex_unlock(&s_propCacheMutex);
+        return;
+    }
+    pthread_mutex_unlock(&s_propCacheMutex);
+
+    if (defaultValue != NULL) {
+        snprintf(value, PROPERTY_VALUE_MAX, "%s", defaultValue);
+    }
+}
+
+int setCachedProp(const char *key, const char *value) {
+    bool unchanged = false;
+    PropCacheEntry *entry = NULL;
+
+    pthread_mutex_lock(&s_propCacheMutex);
+    entry = findEntry(key);
+    if (entry != NULL) {
+        refreshEntry(entry);
+        unchanged = entry->pi != NULL && !strcmp(entry->value, value);
+    }
+    pthread_mutex_unlock(&s_propCacheMutex);
+
+    if (unchanged) {
+        return 0;
+    }
+    return property_set(key, value);
+}
@@ -0,0 +1,32 @@
+/**
+ * prop_cache.h --- cached access to system properties read on request paths
+ *
+ * Copyright (C) 2019 UNISOC Technologies Co.,Ltd.
+ */
+
+#ifndef PROP_CACHE_H_
+#define PROP_CACHE_H_
+
+#include <telephony/ril.h>
+
+/**
+ * Same contract as property_get(). The value is kept together with the
+ * property's serial and only read again once the serial moves, so a hit
+ * costs a table lookup and a serial check.
+ */
+int getCachedProp(const char *key, char *value, const char *defaultValue);
+
+/**
+ * Same contract as getProperty(). The comma separated per-SIM values are
+ * split once per change of the property rather than on every read.
+ */
+void getCachedSimProp(RIL_SOCKET_ID socket_id, const char *key, char *value,
+                      const char *defaultValue);
+
+/**
+ * property_set() unless the property already holds value. Don't use it for
+ * ctl.* or properties init has triggers on, those act on every set.
+ */
+int setCachedProp(const char *key, const char *value);
+
+#endif  // PROP_CACHE_H_
@@ -21,6 +21,8 @@
 #include <sys/socket.h>
 #include <termios.h>
 #include <dlfcn.h>
+#include <poll.h>
+#include <sys/inotify.h>
 #include <hardware/ril/librilutils/proto/sap-api.pb.h>
 #include "pb_decode.h"
 #include "pb_encode.h"
@@ -122,6 +124,14 @@ const struct timeval TIMEVAL_SIMPOLL = {1, 0};
 
 /* trigger change to this with s_radioStateCond */
 static int s_closed[SIM_COUNT];
+/* set by initializeCallback once it runs, also signalled with s_radioStateCond */
+static int s_initStarted[SIM_COUNT];
+
+/* recovery timing of the current (re)start, in getMonotonicMsec() */
+#define TTY_OPEN_RETRY_MIN_MSEC     50
+#define TTY_OPEN_RETRY_MAX_MSEC     1000
+static long long s_aliveMsec[SIM_COUNT];
+static long long s_channelsOpenMsec[SIM_COUNT];
 
 #if defined (ANDROID_MULTI_SIM)
 static void onSapRequest(int request, void *data, size_t datalen, RIL_Token t,
@@ -297,6 +307,136 @@ ATCmdType getCmdType(int request) {
     return cmdType;
 }
 
+/**
+ * Emergency lane: EMERGENCY_DIAL, and hang up while an emergency call is up,
+ * skip the request queues and run on a thread of their own, whose AT commands
+ * use the reserved channel of the SIM (see acquireChannel() in atchannel.c).
+ */
+typedef struct EmergencyRequest {
+    int request;
+    void *data;
+    size_t datalen;
+    RIL_Token t;
+    RIL_SOCKET_ID socket_id;
+    long long arrivalMsec;
+    struct EmergencyRequest *next;
+} EmergencyRequest;
+
+static EmergencyRequest *s_emergencyHead = NULL;
+static EmergencyRequest *s_emergencyTail = NULL;
+static pthread_mutex_t s_emergencyMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_emergencyCond = PTHREAD_COND_INITIALIZER;
+
+static bool isEmergencyLaneRequest(int request) {
+    if (!s_emergencyLaneStarted) {
+        return false;
+    }
+    if (request == RIL_REQUEST_EMERGENCY_DIAL) {
+        return true;
+    }
+    return s_emergencyCalling &&
+           (request == RIL_REQUEST_HANGUP
+            || request == RIL_REQUEST_HANGUP_WAITING_OR_BACKGROUND
+            || request == RIL_REQUEST_HANGUP_FOREGROUND_RESUME_BACKGROUND);
+}
+
+/**
+ * The caller of onRequest owns data only until it returns, so copy what
+ * the handlers use. A redial issued by ril_call.c itself (t == NULL) passes
+ * heap data that processCallRequest frees, so it is taken over as is.
+ */
+static void *copyEmergencyRequestData(int request, void *data, size_t datalen,
+                                      RIL_Token t) {
+    if (t == NULL || data == NULL) {
+        return data;
+    }
+    if (request == RIL_REQUEST_EMERGENCY_DIAL) {
+        RIL_EmergencyNumber *p_dial = (RIL_EmergencyNumber *)data;
+        RIL_EmergencyNumber *p_copy = (RIL_EmergencyNumber *)calloc(1,
+                sizeof(RIL_EmergencyNumber));
+        if (p_copy == NULL) return NULL;
+        p_copy->number = strdup(p_dial->number != NULL ? p_dial->number : "");
+        p_copy->categories = p_dial->categories;
+        p_copy->sources = p_dial->sources;
+        p_copy->clir = p_dial->clir;
+        p_copy->routing = p_dial->routing;
+        p_copy->hasKnownUserIntentEmergency = p_dial->hasKnownUserIntentEmergency;
+        return p_copy;
+    }
+    void *p_copy = malloc(datalen);
+    if (p_copy != NULL) {
+        memcpy(p_copy, data, datalen);
+    }
+    return p_copy;
+}
+
+static void freeEmergencyRequest(EmergencyRequest *req) {
+    if (req->t != NULL && req->data != NULL) {
+        if (req->request == RIL_REQUEST_EMERGENCY_DIAL) {
+            free(((RIL_EmergencyNumber *)req->data)->number);
+        }
+        free(req->data);
+    }
+    free(req);
+}
+
+static bool enqueueEmergencyRequest(int request, void *data, size_t datalen,
+                                    RIL_Token t, RIL_SOCKET_ID socket_id) {
+    EmergencyRequest *req = (EmergencyRequest *)calloc(1, sizeof(EmergencyRequest));
+    if (req == NULL) {
+        return false;
+    }
+    req->arrivalMsec = getMonotonicMsec();
+    req->request = request;
+    req->datalen = datalen;
+    req->t = t;
+    req->socket_id = socket_id;
+    req->data = copyEmergencyRequestData(request, data, datalen, t);
+    if (data != NULL && req->data == NULL) {
+        free(req);
+        return false;
+    }
+
+    pthread_mutex_lock(&s_emergencyMutex);
+    if (s_emergencyTail == NULL) {
+        s_emergencyHead = req;
+    } else {
+        s_emergencyTail->next = req;
+    }
+    s_emergencyTail = req;
+    pthread_cond_signal(&s_emergencyCond);
+    pthread_mutex_unlock(&s_emergencyMutex);
+    return true;
+}
+
+static void *emergencyLaneLoop(void *param) {
+    RIL_UNUSED_PARM(param);
+
+    EmergencyRequest *req = NULL;
+
+    for (;;) {
+        pthread_mutex_lock(&s_emergencyMutex);
+        while (s_emergencyHead == NULL) {
+            pthread_cond_wait(&s_emergencyCond, &s_emergencyMutex);
+        }
+        req = s_emergencyHead;
+        s_emergencyHead = req->next;
+        if (s_emergencyHead == NULL) {
+            s_emergencyTail = NULL;
+        }
+        pthread_mutex_unlock(&s_emergencyMutex);
+
+        at_emergency_lane_begin(req->arrivalMsec);
+        processRequest(req->request, req->data, req->datalen, req->t,
+                       req->socket_id);
+        RLOGD("emergency lane: %s done %lld ms after arrival",
+              requestToString(req->request),
+              getMonotonicMsec() - req->arrivalMsec);
+        freeEmergencyRequest(req);
+    }
+    return NULL;
+}
+
 /**
  * Callback methods from the RIL library to us
  * Call from RIL to us to make a RIL_REQUEST
@@ -320,6 +460,18 @@ void onRequest(int request, void *data, size_t datalen, RIL_Token t)
 {
     ATCmdType cmdType = getCmdType(request);
 
+#if defined(ANDROID_MULTI_SIM)
+    if (isEmergencyLaneRequest(request) &&
+        enqueueEmergencyRequest(request, data, datalen, t, socket_id)) {
+        return;
+    }
+#else
+    if (isEmergencyLaneRequest(request) &&
+        enqueueEmergencyRequest(request, data, datalen, t, RIL_SOCKET_1)) {
+        return;
+    }
+#endif
+
 #if defined(ANDROID_MULTI_SIM)
     enqueueRequestMessgae(request, cmdType, data, datalen, t, socket_id);
 #else
@@ -788,6 +940,7 @@ void resetGlobalVariables() {
     onModemReset_Sms();
     onModemReset_Ss();
     onModemReset_Stk();
+    onModemReset_Misc();
 }
 
 #if 0  // sim ready initialization move to initializeCallback
@@ -1254,6 +1407,11 @@ static void *initializeCallback(void *param) {
         return NULL;
     }
 
+    pthread_mutex_lock(&s_radioStateMutex[socket_id]);
+    s_initStarted[socket_id] = 1;
+    pthread_cond_broadcast(&s_radioStateCond[socket_id]);
+    pthread_mutex_unlock(&s_radioStateMutex[socket_id]);
+
     setRadioState(socket_id, RADIO_STATE_OFF);
 
     /* note: we don't check errors here. Everything important will
@@ -1440,9 +1598,128 @@ static void *initializeCallback(void *param) {
     sem_post(&(s_sem[socket_id]));
     queryCesqVersion(socket_id);
 
+    if (s_modemDownMsec > 0) {
+        long long now = getMonotonicMsec();
+        RLOGD("recovery[%d]: down->alive %lld ms, alive->channels %lld ms, "
+              "init %lld ms, total %lld ms", socket_id,
+              s_aliveMsec[socket_id] - s_modemDownMsec,
+              s_channelsOpenMsec[socket_id] - s_aliveMsec[socket_id],
+              now - s_channelsOpenMsec[socket_id], now - s_modemDownMsec);
+    }
+
     return NULL;
 }
 
+static void waitForInitializeStarted(RIL_SOCKET_ID socket_id) {
+    pthread_mutex_lock(&s_radioStateMutex[socket_id]);
+
+    while (s_initStarted[socket_id] == 0) {
+        pthread_cond_wait(&s_radioStateCond[socket_id],
+                            &s_radioStateMutex[socket_id]);
+    }
+
+    pthread_mutex_unlock(&s_radioStateMutex[socket_id]);
+}
+
+/**
+ * Waits up to timeoutMsec before the next open() of path. If the node is
+ * missing (the mux recreates it after a modem reset) wake up as soon as
+ * something is created in its directory instead of sleeping it out.
+ */
+static void waitForTtyNode(const char *path, int timeoutMsec) {
+    char dir[ARRAY_SIZE] = {0};
+    char *slash = NULL;
+    struct pollfd pfd;
+
+    snprintf(dir, sizeof(dir), "%s", path);
+    slash = strrchr(dir, '/');
+    if (access(path, F_OK) == 0 || slash == NULL || slash == dir) {
+        poll(NULL, 0, timeoutMsec);
+        return;
+    }
+    *slash = '\0';
+
+    pfd.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (pfd.fd < 0) {
+        poll(NULL, 0, timeoutMsec);
+        return;
+    }
+    pfd.events = POLLIN;
+    if (inotify_add_watch(pfd.fd, dir, IN_CREATE | IN_ATTRIB) < 0) {
+        poll(NULL, 0, timeoutMsec);
+    } else if (access(path, F_OK) != 0) {  // it may have shown up meanwhile
+        poll(&pfd, 1, timeoutMsec);
+    }
+    close(pfd.fd);
+}
+
+/* opens one AT tty and disables echo, returns -1 if the node isn't there */
+static int openATChannel(const char *ttyName) {
+    int fd = -1;
+    struct termios ios;
+
+    fd = open(ttyName, O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        return -1;
+    }
+
+    /* disable echo on serial ports */
+    tcgetattr(fd, &ios);
+    ios.c_lflag = 0;  /* disable ECHO, ICANON, etc... */
+    tcsetattr(fd, TCSANOW, &ios);
+    return fd;
+}
+
+/**
+ * Opens the ttys of [firstChannel, lastChannel) into fds. Every round tries
+ * all channels still missing, so the nodes the mux has already created are
+ * opened right away and a late one doesn't hold up the ones behind it.
+ * Between rounds wait for the first missing node with backoff.
+ */
+static void openATChannels(const char *prefix, int firstChannel,
+                           int lastChannel, int *fds) {
+    int channelID = 0;
+    int pending = 0;
+    int rounds = 0;
+    int delayMsec = TTY_OPEN_RETRY_MIN_MSEC;
+    char ttyName[ARRAY_SIZE] = {0};
+    char missing[ARRAY_SIZE] = {0};
+
+    for (channelID = firstChannel; channelID < lastChannel; channelID++) {
+        fds[channelID] = -1;
+    }
+
+    for (;;) {
+        pending = 0;
+        for (channelID = firstChannel; channelID < lastChannel; channelID++) {
+            if (fds[channelID] >= 0) {
+                continue;
+            }
+            snprintf(ttyName, sizeof(ttyName), "%s%d", prefix, channelID);
+            fds[channelID] = openATChannel(ttyName);
+            if (fds[channelID] >= 0) {
+                RLOGI("AT channel open successfully, ttyName:%s, rounds:%d",
+                      ttyName, rounds);
+            } else if (pending++ == 0) {
+                snprintf(missing, sizeof(missing), "%s", ttyName);
+                if (rounds == 0) {
+                    RLOGE("Opening AT interface %s: %s. retrying...", ttyName,
+                          strerror(errno));
+                }
+            }
+        }
+        if (pending == 0) {
+            return;
+        }
+
+        rounds++;
+        waitForTtyNode(missing, delayMsec);
+        if (delayMsec < TTY_OPEN_RETRY_MAX_MSEC) {
+            delayMsec *= 2;
+        }
+    }
+}
+
 static void waitForClose(RIL_SOCKET_ID socket_id) {
     pthread_mutex_lock(&s_radioStateMutex[socket_id]);
 
@@ -1556,11 +1833,11 @@ static void onATTimeout(RIL_SOCKET_ID socket_id) {
 #endif
 
 static void *mainLoop(void *param) {
-    int fd = -1, ret = -1;
+    int ret = -1;
     int channelID = 0;
     int firstChannel, lastChannel;
+    int fds[MAX_AT_CHANNELS];
     char prop[PROPERTY_VALUE_MAX] = {0};
-    char ttyName[ARRAY_SIZE] = {0};
     char channelName[ARRAY_SIZE] = {0};
     RIL_SOCKET_ID socket_id = *((RIL_SOCKET_ID *)param);
 
@@ -1577,42 +1854,26 @@ static void *mainLoop(void *param) {
     lastChannel = MAX_AT_CHANNELS;
 #endif
 
-    property_get(MODEM_TTY_PROP, prop, "/dev/sdiomux");
+    getCachedProp(MODEM_TTY_PROP, prop, "/dev/sdiomux");
 
     for (;;) {
         waitForModemAlive(socket_id);
         RLOGD("Modem alive, start to open channels and create readerLoop");
+        s_aliveMsec[socket_id] = getMonotonicMsec();
 
-        fd = -1;
         s_closed[socket_id] = 0;
+        s_initStarted[socket_id] = 0;
         init_channels(socket_id);
         if (socket_id == RIL_SOCKET_1) {
             resetGlobalVariables();
         }
 
- again:
-        for (channelID = firstChannel; channelID < lastChannel; channelID++) {
-            snprintf(ttyName, sizeof(ttyName), "%s%d", prop, channelID);
-
-            fd = open(ttyName, O_RDWR | O_NONBLOCK);
-
-            if (fd >= 0) {
-                /* disable echo on serial ports */
-                struct termios ios;
-                tcgetattr(fd, &ios);
-                ios.c_lflag = 0;  /* disable ECHO, ICANON, etc... */
-                tcsetattr(fd, TCSANOW, &ios);
-                RLOGI("AT channel [%d] open successfully, ttyName:%s",
-                        channelID, ttyName);
-            } else {
-                RLOGE("Opening AT interface. retrying...");
-                sleep(1);
-                goto again;
-            }
+        openATChannels(prop, firstChannel, lastChannel, fds);
 
+        for (channelID = firstChannel; channelID < lastChannel; channelID++) {
             snprintf(channelName, sizeof(channelName), "Channel%d", channelID);
-            s_ATChannels[channelID] = at_open(fd, channelID, channelName,
-                    onUnsolicited);
+            s_ATChannels[channelID] = at_open(fds[channelID], channelID,
+                    channelName, onUnsolicited);
 
             if (s_ATChannels[channelID] == NULL) {
                 RLOGE("AT error on at_open\n");
@@ -1623,6 +1884,7 @@ static void *mainLoop(void *param) {
             }
         }
 
+        s_channelsOpenMsec[socket_id] = getMonotonicMsec();
         start_reader(socket_id);
 
         setChannelInitialized(socket_id);
@@ -1636,7 +1898,7 @@ static void *mainLoop(void *param) {
 
         /* Give initializeCallback a chance to dispatched, since
          * we don't presently have a cancellation mechanism */
-        sleep(1);
+        waitForInitializeStarted(socket_id);
 
         waitForClose(socket_id);
         RLOGI("Re-opening after close");
@@ -1753,6 +2015,13 @@ const RIL_RadioFunctions *RIL_Init(const struct RIL_Env *env,
     }
     initOperatorInfoList(&s_operatorXmlInfoList);
 
+    ret = pthread_create(&s_emergencyLaneTid, &attr, emergencyLaneLoop, NULL);
+    if (ret != 0) {
+        RLOGE("Failed to create emergencyLaneLoop, use the request queues");
+    } else {
+        s_emergencyLaneStarted = true;
+    }
+
     pthread_t tid;
     ret = pthread_create(&tid, &attr, detectModemState, NULL);
     if (ret < 0) {
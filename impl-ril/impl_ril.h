@@ -36,6 +36,8 @@
 #include "atchannel.h"
 #include "at_tok.h"
 #include "misc.h"
+#include "codec.h"
+#include "prop_cache.h"
 
 #define NEW_AT
 #ifdef NEW_AT
@@ -21,7 +21,28 @@ RIL_EmergencyNumber s_defaultEccWithSim[NUM_ECC_WITH_SIM];
 int s_simEccLen[SIM_COUNT] = {0};
 bool s_emergencyCalling = false;
 bool s_needRedial = false;
-char s_realEccList[SIM_COUNT][ARRAY_SIZE * 2];
+
+#define ECC_NUMBER_LEN  32
+
+/**
+ * Emergency numbers compiled into an open addressing hash set.
+ * A table is never modified once published, a new list replaces it.
+ */
+typedef struct {
+    char number[ECC_NUMBER_LEN];  /* empty for an unused slot */
+    int category;
+} EccEntry;
+
+typedef struct {
+    unsigned int mask;  /* slot count - 1, slot count is a power of 2 */
+    int count;
+    EccEntry slots[];
+} EccTable;
+
+static EccTable *s_eccTable[SIM_COUNT];  /* network and SIM ECC */
+static EccTable *s_defaultEccTableWithSim = NULL;
+static EccTable *s_defaultEccTableWithoutSim = NULL;
+static pthread_mutex_t s_eccTableMutex = PTHREAD_MUTEX_INITIALIZER;
 
 RIL_EmergencyNumber *s_simEccList[SIM_COUNT] = {
         NULL
@@ -88,12 +109,50 @@ static int s_videoCallId[SIM_COUNT] = {
 #endif
 };
 
+/**
+ * Calls of the last AT+CLCC/AT+CLCCS, kept in step by ^DSCI so that
+ * GET_CURRENT_CALLS does not go to the modem unless something changed
+ */
+typedef struct {
+    bool valid;
+    bool isVoLTE;
+    int count;
+    int generation;
+    ATResponse *p_response;  /* owns the strings the calls point into */
+    RIL_Call *calls;
+    RIL_Call_VoLTE *volteCalls;
+} CallTable;
+
+static CallTable s_callTable[SIM_COUNT];
+static pthread_mutex_t s_callTableMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * RIL_REQUEST_DTMF digits waiting to be sent. Digits queued while a burst
+ * is on the wire go out together in the next AT+VTS command line.
+ */
+#define DTMF_BURST_MAX_DIGITS   16
+
+typedef struct DtmfDigit {
+    char digit;
+    RIL_Token t;
+    long long arrivalMsec;
+    struct DtmfDigit *next;
+} DtmfDigit;
+
+static DtmfDigit *s_dtmfHead[SIM_COUNT];
+static DtmfDigit *s_dtmfTail[SIM_COUNT];
+static bool s_dtmfSending[SIM_COUNT];
+static long long s_lastDtmfMsec[SIM_COUNT];
+static pthread_mutex_t s_dtmfMutex = PTHREAD_MUTEX_INITIALIZER;
+
 // add for Bug 1059975
 static bool s_isDuringCdmaFlash = false;
 // add for Bug 1130651
 int s_callCount[SIM_COUNT];
 
 void list_remove(RIL_SOCKET_ID socket_id, ListNode *item);
+static void invalidateCallTable(RIL_SOCKET_ID socket_id);
+static void cancelPendingDtmf(RIL_SOCKET_ID socket_id);
 
 void onModemReset_Call() {
     RIL_SOCKET_ID socket_id = RIL_SOCKET_1;
@@ -103,6 +162,8 @@ void onModemReset_Call() {
         s_videoCallId[socket_id] = -1;
         s_maybeAddCall = 0;
         s_callCount[socket_id] = 0;
+        invalidateCallTable(socket_id);
+        cancelPendingDtmf(socket_id);
 
         ListNode *pList = s_DTMFList[socket_id].next;
         ListNode *next = NULL;
@@ -149,6 +210,7 @@ void list_remove(RIL_SOCKET_ID socket_id, ListNode *item) {
 
 void reportCallStateChanged(void *param) {
     RIL_SOCKET_ID socket_id = *((RIL_SOCKET_ID *)param);
+    invalidateCallTable(socket_id);
     if (s_imsRegistered[socket_id]) {
         RIL_onUnsolicitedResponse(RIL_EXT_UNSOL_RESPONSE_IMS_CALL_STATE_CHANGED,
                                   NULL, 0, socket_id);
@@ -509,6 +571,84 @@ int all_calls(RIL_SOCKET_ID socket_id, int do_mute) {
     return countCalls;
 }
 
+static unsigned int hashEccNumber(const char *number) {
+    unsigned int hash = 2166136261u;  // FNV-1a
+
+    while (*number != '\0') {
+        hash = (hash ^ (unsigned char)*number++) * 16777619u;
+    }
+    return hash;
+}
+
+static EccTable *newEccTable(int maxCount) {
+    unsigned int size = 4;
+    EccTable *table = NULL;
+
+    while (size < (unsigned int)maxCount * 2) {
+        size <<= 1;
+    }
+    table = (EccTable *)calloc(1, sizeof(EccTable) + size * sizeof(EccEntry));
+    if (table != NULL) {
+        table->mask = size - 1;
+    }
+    return table;
+}
+
+/* the first category added for a number is kept */
+static void addEccNumber(EccTable *table, const char *number, int category) {
+    unsigned int i;
+
+    if (table == NULL || number == NULL || number[0] == '\0') return;
+    if (strlen(number) >= ECC_NUMBER_LEN) {
+        RLOGE("ecc number %s is too long", number);
+        return;
+    }
+    for (i = hashEccNumber(number) & table->mask;
+         table->slots[i].number[0] != '\0'; i = (i + 1) & table->mask) {
+        if (strcmp(table->slots[i].number, number) == 0) return;
+    }
+    snprintf(table->slots[i].number, ECC_NUMBER_LEN, "%s", number);
+    table->slots[i].category = category;
+    table->count++;
+}
+
+static const EccEntry *findEccNumber(const EccTable *table, const char *number) {
+    unsigned int i;
+
+    if (table == NULL || number == NULL) return NULL;
+    for (i = hashEccNumber(number) & table->mask;
+         table->slots[i].number[0] != '\0'; i = (i + 1) & table->mask) {
+        if (strcmp(table->slots[i].number, number) == 0) {
+            return &table->slots[i];
+        }
+    }
+    return NULL;
+}
+
+static EccTable *compileEccList(const RIL_EmergencyNumber *list, int len) {
+    EccTable *table = newEccTable(len);
+
+    for (int i = 0; i < len; i++) {
+        addEccNumber(table, list[i].number, list[i].categories);
+    }
+    return table;
+}
+
+/* publishes table, which may be NULL when there is no network or SIM ECC */
+static void setEccTable(RIL_SOCKET_ID socket_id, EccTable *table) {
+    EccTable *old = NULL;
+
+    if (table != NULL && table->count == 0) {
+        free(table);
+        table = NULL;
+    }
+    pthread_mutex_lock(&s_eccTableMutex);
+    old = s_eccTable[socket_id];
+    s_eccTable[socket_id] = table;
+    pthread_mutex_unlock(&s_eccTableMutex);
+    free(old);
+}
+
 void initDefaultEccList() {
     const char *eccNumberWithoutSim[NUM_ECC_WITHOUT_SIM] = {"112", "911", "000", "08", "110", "118", "119", "999"};
     const char *eccNumberWithSim[NUM_ECC_WITH_SIM] = {"112", "911"};
@@ -532,6 +672,228 @@ void initDefaultEccList() {
         s_defaultEccWithSim[i].urns = NULL;
         s_defaultEccWithSim[i].sources = SOURCE_DEFAULT;
     }
+
+    if (s_defaultEccTableWithSim == NULL) {
+        s_defaultEccTableWithSim = compileEccList(s_defaultEccWithSim, NUM_ECC_WITH_SIM);
+    }
+    if (s_defaultEccTableWithoutSim == NULL) {
+        s_defaultEccTableWithoutSim = compileEccList(s_defaultEccWithoutSim,
+                                                     NUM_ECC_WITHOUT_SIM);
+    }
+}
+
+/* assumes s_callTableMutex is held */
+static void clearCallTable(CallTable *table) {
+    at_response_free(table->p_response);
+    free(table->calls);
+    free(table->volteCalls);
+    table->p_response = NULL;
+    table->calls = NULL;
+    table->volteCalls = NULL;
+    table->count = 0;
+    table->valid = false;
+}
+
+/**
+ * Returns true if the call table knows index as the active call. Without
+ * a valid table it is not known, and false is returned.
+ */
+static bool isActiveCallIndex(RIL_SOCKET_ID socket_id, int index) {
+    int i = 0;
+    bool ret = false;
+    CallTable *table = &s_callTable[socket_id];
+
+    pthread_mutex_lock(&s_callTableMutex);
+    for (i = 0; table->valid && i < table->count; i++) {
+        if (table->isVoLTE) {
+            if (table->volteCalls[i].index == index) {
+                ret = (table->volteCalls[i].state == RIL_CALL_ACTIVE);
+                break;
+            }
+        } else if (table->calls[i].index == index) {
+            ret = (table->calls[i].state == RIL_CALL_ACTIVE);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_callTableMutex);
+    return ret;
+}
+
+static void invalidateCallTable(RIL_SOCKET_ID socket_id) {
+    pthread_mutex_lock(&s_callTableMutex);
+    clearCallTable(&s_callTable[socket_id]);
+    s_callTable[socket_id].generation++;
+    pthread_mutex_unlock(&s_callTableMutex);
+}
+
+static int getCallTableGeneration(RIL_SOCKET_ID socket_id) {
+    int generation = 0;
+
+    pthread_mutex_lock(&s_callTableMutex);
+    generation = s_callTable[socket_id].generation;
+    pthread_mutex_unlock(&s_callTableMutex);
+    return generation;
+}
+
+/**
+ * Takes ownership of p_response and calls. Nothing is kept if the table
+ * was invalidated since the AT+CLCC(S) was sent.
+ */
+static void saveCallTable(RIL_SOCKET_ID socket_id, int generation, bool isVoLTE,
+                          ATResponse *p_response, void *calls, int count) {
+#ifndef POLL_CALL_STATE
+    CallTable *table = &s_callTable[socket_id];
+
+    pthread_mutex_lock(&s_callTableMutex);
+    if (table->generation == generation) {
+        clearCallTable(table);
+        table->valid = true;
+        table->isVoLTE = isVoLTE;
+        table->count = count;
+        table->p_response = p_response;
+        if (isVoLTE) {
+            table->volteCalls = (RIL_Call_VoLTE *)calls;
+        } else {
+            table->calls = (RIL_Call *)calls;
+        }
+        p_response = NULL;
+        calls = NULL;
+    }
+    pthread_mutex_unlock(&s_callTableMutex);
+#endif
+    at_response_free(p_response);
+    free(calls);
+}
+
+/* returns true if the request was answered from the call table */
+static bool respondFromCallTable(RIL_SOCKET_ID socket_id, RIL_Token t,
+                                 bool isVoLTE) {
+#ifdef POLL_CALL_STATE
+    /* no call progress URCs to keep the table in step */
+    return false;
+#else
+    int i = 0;
+    bool ret = false;
+    CallTable *table = &s_callTable[socket_id];
+
+    pthread_mutex_lock(&s_callTableMutex);
+    if (!table->valid || table->isVoLTE != isVoLTE) {
+        goto done;
+    }
+
+    if (table->count == 0) s_emergencyCalling = false;
+    process_calls(table->count, socket_id);
+    s_maybeAddCall = 0;
+    if (isVoLTE) {
+        RIL_Call_VoLTE **pp_calls =
+                (RIL_Call_VoLTE **)alloca(table->count * sizeof(RIL_Call_VoLTE *));
+        for (i = 0; i < table->count; i++) {
+            pp_calls[i] = &(table->volteCalls[i]);
+            if (pp_calls[i]->state == RIL_CALL_HOLDING ||
+                pp_calls[i]->state == RIL_CALL_WAITING) {
+                s_maybeAddCall = 1;
+            }
+        }
+        RIL_onRequestComplete(t, RIL_E_SUCCESS, pp_calls,
+                              table->count * sizeof(RIL_Call_VoLTE *));
+    } else {
+        RIL_Call **pp_calls = (RIL_Call **)alloca(table->count * sizeof(RIL_Call *));
+        for (i = 0; i < table->count; i++) {
+            pp_calls[i] = &(table->calls[i]);
+            if (pp_calls[i]->state == RIL_CALL_HOLDING ||
+                pp_calls[i]->state == RIL_CALL_WAITING) {
+                s_maybeAddCall = 1;
+            }
+        }
+        RIL_onRequestComplete(t, RIL_E_SUCCESS, pp_calls,
+                              table->count * sizeof(RIL_Call *));
+    }
+    ret = true;
+
+done:
+    pthread_mutex_unlock(&s_callTableMutex);
+    return ret;
+#endif
+}
+
+/**
+ * Applies a ^DSCI call state to the table. A call the table does not know
+ * about, or a change that ^DSCI does not fully describe, forces a resync.
+ */
+static void updateCallTable(RIL_SOCKET_ID socket_id, int id, int stat, int mpty) {
+    int i = 0;
+    bool synced = false;
+    CallTable *table = &s_callTable[socket_id];
+
+    pthread_mutex_lock(&s_callTableMutex);
+    if (!table->valid) {
+        goto done;
+    }
+
+    for (i = 0; i < table->count; i++) {
+        int index = table->isVoLTE ? table->volteCalls[i].index : table->calls[i].index;
+        if (index != id) continue;
+
+        if (stat == 6) {  // disconnected
+            int left = table->count - i - 1;
+            if (table->isVoLTE) {
+                memmove(&table->volteCalls[i], &table->volteCalls[i + 1],
+                        left * sizeof(RIL_Call_VoLTE));
+            } else {
+                memmove(&table->calls[i], &table->calls[i + 1],
+                        left * sizeof(RIL_Call));
+            }
+            table->count--;
+            synced = true;
+        } else if (!table->isVoLTE &&
+                   clccStateToRILState(stat, &table->calls[i].state) == 0) {
+            /* VoLTE calls also carry media state, which ^DSCI does not */
+            table->calls[i].isMpty = mpty;
+            synced = true;
+        }
+        break;
+    }
+
+    if (!synced) {
+        clearCallTable(table);
+    }
+    table->generation++;
+
+done:
+    pthread_mutex_unlock(&s_callTableMutex);
+}
+
+/* call progress URCs that are not described by ^DSCI */
+static bool isCallTableChangingUnsol(const char *s) {
+    return strStartsWith(s, "RING") || strStartsWith(s, "+CRING:") ||
+           strStartsWith(s, "NO CARRIER") || strStartsWith(s, "+CCWA") ||
+           strStartsWith(s, "+CMCCSI:") || strStartsWith(s, "+CMCCSS") ||
+           strStartsWith(s, "+CIREPH") || strStartsWith(s, "+IMSHOU") ||
+           strStartsWith(s, "+SCSFB") || strStartsWith(s, "+CSSSFB");
+}
+
+/* requests which do not change the calls reported by AT+CLCC(S) */
+static bool isCallTableKeptRequest(int request) {
+    switch (request) {
+        case RIL_REQUEST_GET_CURRENT_CALLS:
+        case RIL_EXT_REQUEST_GET_IMS_CURRENT_CALLS:
+        case RIL_REQUEST_LAST_CALL_FAIL_CAUSE:
+        case RIL_REQUEST_DTMF:
+        case RIL_REQUEST_DTMF_START:
+        case RIL_REQUEST_DTMF_STOP:
+        case RIL_REQUEST_CDMA_BURST_DTMF:
+        case RIL_REQUEST_QUERY_TTY_MODE:
+        case RIL_REQUEST_CDMA_QUERY_PREFERRED_VOICE_PRIVACY_MODE:
+        case RIL_EXT_REQUEST_GET_IMS_VOICE_CALL_AVAILABILITY:
+        case RIL_EXT_REQUEST_GET_HD_VOICE_STATE:
+        case RIL_EXT_REQUEST_GET_TPMR_STATE:
+        case RIL_EXT_REQUEST_GET_VIDEO_RESOLUTION:
+        case RIL_EXT_REQUEST_GET_IMS_PANI_INFO:
+        case RIL_EXT_REQUEST_GET_IMS_SRVCC_CAPBILITY:
+            return true;
+        default:
+            return false;
+    }
 }
 
 static void requestGetCurrentCalls(RIL_SOCKET_ID socket_id, void *data,
@@ -543,11 +905,17 @@ static void requestGetCurrentCalls(RIL_SOCKET_ID socket_id, void *data,
     int i = 0, countCalls = 0;
     int countValidCalls = 0;
     int needRepoll = 0;
+    int generation = 0;
     ATResponse *p_response = NULL;
     ATLine *p_cur = NULL;
     RIL_Call *p_calls = NULL;
     RIL_Call **pp_calls = NULL;
 
+    if (respondFromCallTable(socket_id, t, false)) {
+        return;
+    }
+
+    generation = getCallTableGeneration(socket_id);
     err = at_send_command_multiline(socket_id, "AT+CLCC", "+CLCC:", &p_response);
     if (err != 0 || p_response->success == 0) {
         RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
@@ -565,8 +933,12 @@ static void requestGetCurrentCalls(RIL_SOCKET_ID socket_id, void *data,
 
     /* there's an array of pointers and then an array of structures */
     pp_calls = (RIL_Call **)alloca(countCalls * sizeof(RIL_Call *));
-    p_calls = (RIL_Call *)alloca(countCalls * sizeof(RIL_Call));
-    memset(p_calls, 0, countCalls * sizeof(RIL_Call));
+    p_calls = (RIL_Call *)calloc(countCalls + 1, sizeof(RIL_Call));
+    if (p_calls == NULL) {
+        RIL_onRequestComplete(t, RIL_E_NO_MEMORY, NULL, 0);
+        at_response_free(p_response);
+        return;
+    }
 
     /* init the pointer array */
     for (i = 0; i < countCalls; i++) {
@@ -583,7 +955,8 @@ static void requestGetCurrentCalls(RIL_SOCKET_ID socket_id, void *data,
     }
     RIL_onRequestComplete(t, RIL_E_SUCCESS, pp_calls,
                           countValidCalls * sizeof(RIL_Call *));
-    at_response_free(p_response);
+    saveCallTable(socket_id, generation, false, p_response, p_calls,
+                  countValidCalls);
 #ifdef POLL_CALL_STATE
     if (countValidCalls)
     /* We don't seem to get a "NO CARRIER" message from
@@ -850,32 +1223,151 @@ static void requestUDUB(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
        it will call GET_CURRENT_CALLS and determine success that way */
 }
 
-static void requestDTMF(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
-                        RIL_Token t) {
-    RIL_UNUSED_PARM(datalen);
+/* "AT+VTS=1;+VTS=2;..." for up to DTMF_BURST_MAX_DIGITS digits, see V.250 5.4 */
+static void buildVtsCommand(char *cmd, size_t size, const char *digits, int len) {
+    int offset = snprintf(cmd, size, "AT+VTS=%c", digits[0]);
 
-    int err = -1;
-    char character = ((char *)data)[0];
+    for (int i = 1; i < len && offset < (int)size; i++) {
+        offset += snprintf(cmd + offset, size - offset, ";+VTS=%c", digits[i]);
+    }
+}
+
+static void completeDtmfDigits(DtmfDigit *list, RIL_Errno result) {
+    DtmfDigit *next = NULL;
+
+    while (list != NULL) {
+        next = list->next;
+        RIL_onRequestComplete(list->t, result, NULL, 0);
+        free(list);
+        list = next;
+    }
+}
+
+/* queued digits belong to the active call, in-flight ones still play */
+static void cancelPendingDtmf(RIL_SOCKET_ID socket_id) {
+    DtmfDigit *list = NULL;
+
+    pthread_mutex_lock(&s_dtmfMutex);
+    list = s_dtmfHead[socket_id];
+    s_dtmfHead[socket_id] = NULL;
+    s_dtmfTail[socket_id] = NULL;
+    pthread_mutex_unlock(&s_dtmfMutex);
+
+    if (list != NULL) {
+        RLOGD("cancel pending dtmf on socket %d", socket_id);
+        completeDtmfDigits(list, RIL_E_CANCELLED);
+    }
+}
+
+/**
+ * Sends one burst per timed callback and posts itself again while digits
+ * remain, so other timed callbacks are not held for a whole IVR string.
+ */
+static void sendDtmfBurst(void *param) {
+    RIL_SOCKET_ID socket_id = *((RIL_SOCKET_ID *)param);
     char cmd[AT_COMMAND_LEN] = {0};
+    char digits[DTMF_BURST_MAX_DIGITS + 1] = {0};
+    int count = 0, err = -1;
+    bool more = false;
+    long long startMsec = 0, endMsec = 0;
+    DtmfDigit *burst = NULL, *tail = NULL;
     ATResponse *p_response = NULL;
+    RIL_Errno result = RIL_E_SUCCESS;
 
-    snprintf(cmd, sizeof(cmd), "AT+VTS=%c", (int)character);
+    pthread_mutex_lock(&s_dtmfMutex);
+    burst = s_dtmfHead[socket_id];
+    if (burst == NULL) {
+        s_dtmfSending[socket_id] = false;
+        pthread_mutex_unlock(&s_dtmfMutex);
+        return;
+    }
+    for (count = 0, tail = burst; ; tail = tail->next) {
+        digits[count++] = tail->digit;
+        if (tail->next == NULL || count == DTMF_BURST_MAX_DIGITS) break;
+    }
+    digits[count] = '\0';
+    s_dtmfHead[socket_id] = tail->next;
+    if (s_dtmfHead[socket_id] == NULL) {
+        s_dtmfTail[socket_id] = NULL;
+    }
+    tail->next = NULL;
+    pthread_mutex_unlock(&s_dtmfMutex);
+
+    buildVtsCommand(cmd, sizeof(cmd), digits, count);
+    startMsec = getMonotonicMsec();
     err = at_send_command(socket_id, cmd, &p_response);
+    endMsec = getMonotonicMsec();
     if (err < 0 || p_response->success == 0) {
-        goto error;
+        if (p_response != NULL &&
+                !strcmp(p_response->finalResponse, "+CME ERROR: 22")) {
+            result = RIL_E_INVALID_MODEM_STATE;
+        } else {
+            result = RIL_E_GENERIC_FAILURE;
+        }
     } else {
-        RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
-        at_response_free(p_response);
+        result = RIL_E_SUCCESS;
+    }
+    AT_RESPONSE_FREE(p_response);
+
+    RLOGD("dtmf burst \"%s\": queued %lld ms, sent in %lld ms, "
+          "%lld ms per digit, %lld ms since last burst", digits,
+          startMsec - burst->arrivalMsec,
+          endMsec - startMsec, (endMsec - startMsec) / count,
+          s_lastDtmfMsec[socket_id] == 0 ? 0 :
+          startMsec - s_lastDtmfMsec[socket_id]);
+    s_lastDtmfMsec[socket_id] = endMsec;
+
+    completeDtmfDigits(burst, result);
+
+    pthread_mutex_lock(&s_dtmfMutex);
+    more = (s_dtmfHead[socket_id] != NULL);
+    if (!more) {
+        s_dtmfSending[socket_id] = false;
+    }
+    pthread_mutex_unlock(&s_dtmfMutex);
+
+    if (more) {
+        RIL_requestTimedCallback(sendDtmfBurst, param, NULL);
+    }
+}
+
+/**
+ * Queues the digit and completes the request once it has been played,
+ * so the request thread is not held for the AT+VTS round trip.
+ */
+static void requestDTMF(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
+                        RIL_Token t) {
+    RIL_UNUSED_PARM(datalen);
+
+    bool startSending = false;
+    DtmfDigit *item = (DtmfDigit *)calloc(1, sizeof(DtmfDigit));
+
+    if (item == NULL) {
+        RLOGE("Allocate dtmf digit failed");
+        RIL_onRequestComplete(t, RIL_E_NO_MEMORY, NULL, 0);
         return;
     }
-error:
-    if (p_response != NULL &&
-            !strcmp(p_response->finalResponse, "+CME ERROR: 22")) {
-        RIL_onRequestComplete(t, RIL_E_INVALID_MODEM_STATE, NULL, 0);
+    item->digit = ((char *)data)[0];
+    item->t = t;
+    item->arrivalMsec = getMonotonicMsec();
+
+    pthread_mutex_lock(&s_dtmfMutex);
+    if (s_dtmfTail[socket_id] == NULL) {
+        s_dtmfHead[socket_id] = item;
     } else {
-        RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
+        s_dtmfTail[socket_id]->next = item;
+    }
+    s_dtmfTail[socket_id] = item;
+    if (!s_dtmfSending[socket_id]) {
+        s_dtmfSending[socket_id] = true;
+        startSending = true;
+    }
+    pthread_mutex_unlock(&s_dtmfMutex);
+
+    if (startSending) {
+        RIL_requestTimedCallback(sendDtmfBurst, (void *)&s_socketId[socket_id],
+                                 NULL);
     }
-    at_response_free(p_response);
 }
 
 static void requestAnswer(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
@@ -1057,45 +1549,27 @@ error:
 }
 
 int isEccNumber(RIL_SOCKET_ID socket_id, char *dialNumber, int *catgry) {
-    char *tmpList = NULL;
-    char *tmpNumber = NULL;
-    char *outer_ptr = NULL;
-    char *inner_ptr = NULL;
-    char ecc3GPP_NoSIM[] = "112,911,000,08,110,118,119,999";
-    char ecc3GPP_SIM[] = "112,911";
     int numberExist = 0;
+    const EccEntry *entry = NULL;
 
-    if (strlen(s_realEccList[socket_id]) != 0) {
-        tmpList = s_realEccList[socket_id];
-        while ((tmpNumber = strtok_r(tmpList, ",", &outer_ptr)) != NULL) {
-            tmpList = tmpNumber;
-            if ((tmpNumber = strtok_r(tmpList, "@", &inner_ptr)) != NULL) {
-                if (strcmp(tmpNumber, dialNumber) == 0) {
-                    numberExist = 1;
-                    if (inner_ptr != NULL) {
-                        *catgry = atoi(inner_ptr);
-                    }
-                    break;
-                }
-            }
-            tmpList = NULL;
+    pthread_mutex_lock(&s_eccTableMutex);
+    if (s_eccTable[socket_id] != NULL) {
+        entry = findEccNumber(s_eccTable[socket_id], dialNumber);
+        if (entry != NULL) {
+            numberExist = 1;
+            *catgry = entry->category;
         }
-        return numberExist;
-    }
-
-    if (isSimPresent(socket_id) == 1) {
-        tmpList = ecc3GPP_SIM;
     } else {
-        tmpList = ecc3GPP_NoSIM;
-    }
-
-    while ((tmpNumber = strtok_r(tmpList, ",", &outer_ptr)) != NULL) {
-        if (strcmp(tmpNumber, dialNumber) == 0) {
-            numberExist = 1;
-            break;
+        /* no network or SIM ECC, categories of the default list are unspecified */
+        if (isSimPresent(socket_id) == 1) {
+            entry = findEccNumber(s_defaultEccTableWithSim, dialNumber);
+        } else {
+            entry = findEccNumber(s_defaultEccTableWithoutSim, dialNumber);
         }
-        tmpList = NULL;
+        numberExist = (entry != NULL);
     }
+    pthread_mutex_unlock(&s_eccTableMutex);
+
     return numberExist;
 }
 
@@ -1326,11 +1800,17 @@ static void requestGetCurrentCallsVoLTE(RIL_SOCKET_ID socket_id, void *data,
     int needRepoll = 0;
     int countCalls = 0;
     int countValidCalls = 0;
+    int generation = 0;
     RIL_Call_VoLTE *p_calls = NULL;
     RIL_Call_VoLTE **pp_calls = NULL;
     ATResponse *p_response = NULL;
     ATLine *p_cur = NULL;
 
+    if (respondFromCallTable(socket_id, t, true)) {
+        return;
+    }
+
+    generation = getCallTableGeneration(socket_id);
     err = at_send_command_multiline(socket_id, "AT+CLCCS", "+CLCCS:", &p_response);
     if (err != 0 || p_response->success == 0) {
         RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
@@ -1348,10 +1828,13 @@ static void requestGetCurrentCallsVoLTE(RIL_SOCKET_ID socket_id, void *data,
 
     /* yes, there's an array of pointers and then an array of structures */
     pp_calls = (RIL_Call_VoLTE **)alloca(countCalls * sizeof(RIL_Call_VoLTE *));
-    p_calls = (RIL_Call_VoLTE *)alloca(countCalls * sizeof(RIL_Call_VoLTE));
-    RIL_Call_VoLTE *p_t_calls =
-            (RIL_Call_VoLTE *)alloca(countCalls * sizeof(RIL_Call_VoLTE));
-    memset(p_calls, 0, countCalls * sizeof(RIL_Call_VoLTE));
+    p_calls = (RIL_Call_VoLTE *)calloc(countCalls + 1, sizeof(RIL_Call_VoLTE));
+    if (p_calls == NULL) {
+        RIL_onRequestComplete(t, RIL_E_NO_MEMORY, NULL, 0);
+        at_response_free(p_response);
+        return;
+    }
+    RIL_Call_VoLTE *p_t_calls = NULL;
 
     /* init the pointer array */
     for (i = 0; i < countCalls; i++) {
@@ -1374,7 +1857,8 @@ static void requestGetCurrentCallsVoLTE(RIL_SOCKET_ID socket_id, void *data,
     RIL_onRequestComplete(t, RIL_E_SUCCESS, pp_calls,
                           countValidCalls * sizeof(RIL_Call_VoLTE *));
 
-    at_response_free(p_response);
+    saveCallTable(socket_id, generation, true, p_response, p_calls,
+                  countValidCalls);
 #ifdef POLL_CALL_STATE
     if (countValidCalls) {
     /* We don't seem to get a "NO CARRIER" message from
@@ -1722,6 +2206,10 @@ int processCallRequest(int request, void *data, size_t datalen, RIL_Token t,
             break;
         }
         case RIL_REQUEST_HANGUP: {
+            /* a held or waiting call may be released while digits play */
+            if (data != NULL && isActiveCallIndex(socket_id, ((int *)data)[0])) {
+                cancelPendingDtmf(socket_id);
+            }
             if (!s_isCDMAPhone[socket_id]) {
                 requestHangup(socket_id, data, datalen, t);
             } else {
@@ -1747,6 +2235,8 @@ int processCallRequest(int request, void *data, size_t datalen, RIL_Token t,
             break;
         }
         case RIL_REQUEST_HANGUP_FOREGROUND_RESUME_BACKGROUND: {
+            /* the foreground call is the active one the digits are for */
+            cancelPendingDtmf(socket_id);
             if (!s_isCDMAPhone[socket_id]) {
                 requestHangupForeResumeBack(socket_id, data, datalen, t);
             } else {
@@ -2445,13 +2935,19 @@ int processCallRequest(int request, void *data, size_t datalen, RIL_Token t,
             break;
         }
         case RIL_REQUEST_CDMA_BURST_DTMF: {
-            int i = 0;
+            int i = 0, offset = 0;
             char *dtmf_key = ((char **) data)[0];
             char cmd[AT_COMMAND_LEN] = {0};
             int len = (dtmf_key == NULL) ? 0 : strlen(dtmf_key);
 
-            for (i = 0; i < len; i++) {
-                snprintf(cmd, sizeof(cmd), "AT+VTS=%c,0,0", dtmf_key[i]);
+            /* as many digits per command line as fit */
+            while (i < len) {
+                offset = snprintf(cmd, sizeof(cmd), "AT+VTS=%c,0,0", dtmf_key[i++]);
+                while (i < len &&
+                       offset + (int)sizeof(";+VTS=0,0,0") <= (int)sizeof(cmd)) {
+                    offset += snprintf(cmd + offset, sizeof(cmd) - offset,
+                                       ";+VTS=%c,0,0", dtmf_key[i++]);
+                }
                 at_send_command(socket_id, cmd, NULL);
             }
             RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
@@ -2496,6 +2992,10 @@ int processCallRequest(int request, void *data, size_t datalen, RIL_Token t,
             ret = 0;
             break;
     }
+
+    if (ret && !isCallTableKeptRequest(request)) {
+        invalidateCallTable(socket_id);
+    }
     return ret;
 }
 
@@ -2588,6 +3088,7 @@ static void excuteSrvccPendingOperate(void *param) {
 
 void sendCallStateChanged(void *param) {
     RIL_SOCKET_ID socket_id = *((RIL_SOCKET_ID *)param);
+    invalidateCallTable(socket_id);
     if (s_imsRegistered[socket_id]) {
         RIL_onUnsolicitedResponse(
             RIL_EXT_UNSOL_RESPONSE_IMS_CALL_STATE_CHANGED,
@@ -2601,12 +3102,14 @@ void sendCallStateChanged(void *param) {
 
 void sendCSCallStateChanged(void *param) {
     RIL_SOCKET_ID socket_id = *((RIL_SOCKET_ID *)param);
+    invalidateCallTable(socket_id);
     RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED, NULL, 0,
                               socket_id);
 }
 
 void sendIMSCallStateChanged(void *param) {
     RIL_SOCKET_ID socket_id = *((RIL_SOCKET_ID *)param);
+    invalidateCallTable(socket_id);
     RIL_onUnsolicitedResponse(RIL_EXT_UNSOL_RESPONSE_IMS_CALL_STATE_CHANGED, NULL,
                               0, socket_id);
 }
@@ -2615,8 +3118,8 @@ void sendUnsolEccList(void *param) {
     char *mcc = NULL, *mnc = NULL, *number = NULL, *line = NULL;
     int category = 0;
     int err, i = 0;
-    int pOffset = 0;
     int netEccLen = 0, defaultEccLen = 0, eccListLen = 0;
+    EccTable *eccTable = NULL;
     RIL_EmergencyNumber *defaultEccList = NULL;
     RIL_EmergencyNumber *eccList = NULL;
     ATResponse *p_response = NULL;
@@ -2628,7 +3131,6 @@ void sendUnsolEccList(void *param) {
         return;
     }
 
-    memset(s_realEccList[socket_id], 0, sizeof(s_realEccList[socket_id]));
     err = at_send_command_multiline(socket_id, "AT+CEN?", "+CEN",
                                     &p_response);
     /* AT+CEN? Return:
@@ -2673,6 +3175,7 @@ void sendUnsolEccList(void *param) {
     RLOGD("sendUnsolEccList netEccLen = %d, simEcclen = %d, defaultEccLen = %d",
             netEccLen, s_simEccLen[socket_id], defaultEccLen);
     eccList = (RIL_EmergencyNumber *)calloc(eccListLen, sizeof(RIL_EmergencyNumber));
+    eccTable = newEccTable(netEccLen + s_simEccLen[socket_id]);
 
     for (p_cur = p_response->p_intermediates->p_next; p_cur != NULL;
          p_cur = p_cur->p_next) {
@@ -2700,9 +3203,7 @@ void sendUnsolEccList(void *param) {
         eccList[i].urnsNumber = 0;
         eccList[i].urns = NULL;  // TODO: need cp reported to ap
         eccList[i].sources = SOURCE_NETWORK_SIGNALING;
-        snprintf(s_realEccList[socket_id] + pOffset, sizeof(s_realEccList[socket_id]) - pOffset,
-                ",%s@%d", number, category);
-        pOffset = strlen(s_realEccList[socket_id]);
+        addEccNumber(eccTable, number, category);
         i++;
         RLOGD("sendUnsolEccList, network: category:%d, number:%s, ", category, number);
     }
@@ -2716,14 +3217,12 @@ void sendUnsolEccList(void *param) {
             eccList[i].urnsNumber = s_simEccList[socket_id][j].urnsNumber;
             eccList[i].urns = s_simEccList[socket_id][j].urns;
             eccList[i].sources = SOURCE_SIM;
-            snprintf(s_realEccList[socket_id] + pOffset,
-                    sizeof(s_realEccList[socket_id]) - pOffset,
-                    ",%s@%d", eccList[i].number, eccList[i].categories);
-            pOffset = strlen(s_realEccList[socket_id]);
+            addEccNumber(eccTable, eccList[i].number, eccList[i].categories);
             i++;
         }
-        RLOGD("s_realEccList[%d]=%s", socket_id, s_realEccList[socket_id]);
     }
+    RLOGD("sendUnsolEccList: %d numbers from network and sim",
+          eccTable != NULL ? eccTable->count : 0);
 
     if (defaultEccList != NULL) {
         for (int j = 0; j < defaultEccLen; j++) {
@@ -2742,6 +3241,8 @@ void sendUnsolEccList(void *param) {
                            eccListLen * sizeof(RIL_EmergencyNumber), socket_id);
 
 done:
+    /* numbers parsed before a failure are kept, as they always were */
+    setEccTable(socket_id, eccTable);
     FREEMEMORY(eccList);
     at_response_free(p_response);
 }
@@ -3142,6 +3643,11 @@ int processCallUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
     int err;
     int ret = 1;
     char *line = NULL;
+    bool callTableSynced = true;
+
+    if (isCallTableChangingUnsol(s)) {
+        invalidateCallTable(socket_id);
+    }
 
     if (strStartsWith(s, "+CRING:") ||
         strStartsWith(s, "RING") ||
@@ -3194,6 +3700,7 @@ int processCallUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
                                       sizeof(RIL_CDMA_CallWaiting_v6), socket_id);
         }
     } else if (strStartsWith(s, "^DSCI:")) {
+        callTableSynced = false;
         // add for Bug 1059975
         if (s_isCDMAPhone[socket_id] && s_isDuringCdmaFlash) {
             RLOGD("during cdma flash, don't report call state change to framework.");
@@ -3248,9 +3755,11 @@ int processCallUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
             RLOGE("get number fail");
             goto out;
         }
+        updateCallTable(socket_id, response->id, response->stat, response->mpty);
+        callTableSynced = true;
         if (s_isVoLteEnable) {
             char vowifiState[ARRAY_SIZE] = {0};
-            getProperty(socket_id, "gsm.sys.vowifi.state", vowifiState, "0");
+            getCachedSimProp(socket_id, "gsm.sys.vowifi.state", vowifiState, "0");
             err = at_tok_nextint(&tmp, &response->num_type);
             if (err < 0) {
                 RLOGE("get num_type fail");
@@ -3453,7 +3962,7 @@ int processCallUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
         }
         if (s_isVoLteEnable) {
             char vowifiState[ARRAY_SIZE] = {0};
-            getProperty(socket_id, "gsm.sys.vowifi.state", vowifiState, "0");
+            getCachedSimProp(socket_id, "gsm.sys.vowifi.state", vowifiState, "0");
             RLOGD("CMCCSI vowifiState: %s", vowifiState);
             if ((0 == strcmp(vowifiState, "1") && s_emergencyCalling) || s_needRedial) {
                 RLOGD("emergencyCalling, do not report imsCallstatusChanged");
@@ -3905,6 +4414,9 @@ int processCallUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
     RIL_UNSOL_EXIT_EMERGENCY_CALLBACK_MODE
     */
 out:
+    if (!callTableSynced) {
+        invalidateCallTable(socket_id);
+    }
     free(line);
     return ret;
 }
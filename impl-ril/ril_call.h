@@ -105,6 +105,7 @@ extern RIL_EmergencyNumber *s_simEccList[SIM_COUNT];
 extern RIL_EmergencyNumber s_defaultEccWithoutSim[NUM_ECC_WITHOUT_SIM];
 extern RIL_EmergencyNumber s_defaultEccWithSim[NUM_ECC_WITH_SIM];
 extern int s_callCount[SIM_COUNT];
+extern bool s_emergencyCalling;
 
 void onModemReset_Call();
 
@@ -60,6 +60,24 @@ static int s_openchannelCid = -1;
 
 static int s_curCid[SIM_COUNT];
 
+/* Last data call list reported to framework, used to suppress duplicated
+ * RIL_UNSOL_DATA_CALL_LIST_CHANGED */
+static pthread_mutex_t s_dataCallListMutex = PTHREAD_MUTEX_INITIALIZER;
+static char s_dataCallListDigest[SIM_COUNT][DATA_CALL_DIGEST_LEN];
+static int s_dataCallListDigestLen[SIM_COUNT] = {
+        -1
+#if (SIM_COUNT >= 2)
+        ,-1
+#if (SIM_COUNT >= 3)
+        ,-1
+#if (SIM_COUNT >= 4)
+        ,-1
+#endif
+#endif
+#endif
+};
+static int s_dataCallListVersion[SIM_COUNT];
+
 static int s_fdSocketV4[MAX_PDP];
 static int s_fdSocketV6[MAX_PDP];
 static int s_ethState[MAX_ETH];
@@ -147,6 +165,7 @@ static int detachGPRS(RIL_SOCKET_ID socket_id, RIL_Token t);
 static bool isApnEqual(char *new, char *old);
 static bool isProtocolEqual(char *new, char *old);
 static bool isStrEqual(char *new, char *old);
+static void invalidateDataCallList(RIL_SOCKET_ID socket_id);
 int getEthIndexBySocketId(RIL_SOCKET_ID socket_id, int cid);
 int downNetcard(int cid, char *netinterface, RIL_SOCKET_ID socket_id);
 
@@ -168,6 +187,7 @@ void onModemReset_Data() {
     memset(s_fdSocketV6, -1, sizeof(s_fdSocketV6));
 
     for (socket_id = RIL_SOCKET_1; socket_id < RIL_SOCKET_NUM; socket_id++) {
+        invalidateDataCallList(socket_id);
         s_LTEDetached[socket_id] = 0;
         s_lastPDPFailCause[socket_id] = PDP_FAIL_ERROR_UNSPECIFIED;
         for (i = 0; i < MAX_PDP; i++) {
@@ -1170,7 +1190,7 @@ void getEthNameByCid(RIL_SOCKET_ID socket_id, int cid, char *ethName, size_t len
     char eth[PROPERTY_VALUE_MAX] = {0};
     int ethIndex = getEthIndexBySocketId(socket_id, cid);
 
-    property_get(MODEM_ETH_PROP, eth, "veth");
+    getCachedProp(MODEM_ETH_PROP, eth, "veth");
     snprintf(ethName, len, "%s%d", eth, ethIndex);
 
     RLOGD("getEthNameByCid: socket_id = %d, cid = %d, ethName = %s",
@@ -1182,7 +1202,7 @@ int getCidByEthName(RIL_SOCKET_ID socket_id, char *ethName, size_t len) {
     int ethIndex = 0;
     char eth[PROPERTY_VALUE_MAX] = {0};
     char str[ARRAY_SIZE / 4] = {0};
-    property_get(MODEM_ETH_PROP, eth, "veth");
+    getCachedProp(MODEM_ETH_PROP, eth, "veth");
 
     if (ethName != NULL && len > strlen(eth)) {
         snprintf(str, sizeof(str), "%s", ethName + strlen(eth));
@@ -1209,6 +1229,94 @@ void sendPsDataOffToExtData(RIL_SOCKET_ID socket_id, int exemptionInfo, int port
     sendCmdToExtData(cmd);
 }
 
+static int appendDataCallStrings(char *buf, int len, int offset,
+                                 char **strs, uint32_t num) {
+    uint32_t i = 0;
+
+    for (i = 0; i < num && offset >= 0 && offset < len; i++) {
+        offset += snprintf(buf + offset, len - offset, "%s;",
+                           strs[i] != NULL ? strs[i] : "");
+    }
+    if (offset >= 0 && offset < len) {
+        offset += snprintf(buf + offset, len - offset, "|");
+    }
+    return offset;
+}
+
+/*
+ * Build a flat digest of the data call list, only the fields reported to
+ * framework are included.
+ * return : digest length, or -1 if the digest does not fit into buffer
+ */
+static int buildDataCallListDigest(RIL_SetupDataCallResult_v1_4 *responses,
+                                   int num, char *buf, int len) {
+    int i = 0;
+    int offset = 0;
+
+    for (i = 0; i < num && offset >= 0 && offset < len; i++) {
+        RIL_SetupDataCallResult_v1_4 *dc = &responses[i];
+        if (dc->cid == -1) {
+            continue;
+        }
+        offset += snprintf(buf + offset, len - offset, "%d,%d,%d,%d,%d,%d,%s|",
+                dc->cid, dc->active, dc->cause, dc->suggestedRetryTime,
+                dc->type, dc->mtu, dc->ifname != NULL ? dc->ifname : "");
+        offset = appendDataCallStrings(buf, len, offset, dc->addresses,
+                                       dc->addressesNumber);
+        offset = appendDataCallStrings(buf, len, offset, dc->gateways,
+                                       dc->gatewaysNumber);
+        offset = appendDataCallStrings(buf, len, offset, dc->dnses,
+                                       dc->dnsesNumber);
+        offset = appendDataCallStrings(buf, len, offset, dc->pcscf,
+                                       dc->pcscfNumber);
+    }
+    if (offset < 0 || offset >= len) {
+        return -1;
+    }
+    return offset;
+}
+
+/*
+ * Compare the data call list with the one last reported to framework and
+ * save it as the new snapshot.
+ * return : true if the list is changed or cannot be compared
+ */
+static bool updateDataCallList(RIL_SOCKET_ID socket_id,
+                               RIL_SetupDataCallResult_v1_4 *responses,
+                               int num) {
+    char digest[DATA_CALL_DIGEST_LEN] = {0};
+    bool changed = true;
+    int len = buildDataCallListDigest(responses, num, digest, sizeof(digest));
+
+    pthread_mutex_lock(&s_dataCallListMutex);
+    if (len < 0) {
+        s_dataCallListDigestLen[socket_id] = -1;
+    } else {
+        if (len == s_dataCallListDigestLen[socket_id] &&
+                memcmp(digest, s_dataCallListDigest[socket_id], len) == 0) {
+            changed = false;
+        } else {
+            memcpy(s_dataCallListDigest[socket_id], digest, len);
+            s_dataCallListDigestLen[socket_id] = len;
+        }
+    }
+    if (changed) {
+        s_dataCallListVersion[socket_id]++;
+    }
+    RLOGD("data call list version: %d, changed: %d",
+          s_dataCallListVersion[socket_id], changed);
+    pthread_mutex_unlock(&s_dataCallListMutex);
+
+    return changed;
+}
+
+/* framework's view of data call list is unknown, next list must be reported */
+static void invalidateDataCallList(RIL_SOCKET_ID socket_id) {
+    pthread_mutex_lock(&s_dataCallListMutex);
+    s_dataCallListDigestLen[socket_id] = -1;
+    pthread_mutex_unlock(&s_dataCallListMutex);
+}
+
 static void requestOrSendDataCallList(RIL_SOCKET_ID socket_id, int cid,
                                       RIL_Token *t) {
     int err;
@@ -1241,6 +1349,7 @@ static void requestOrSendDataCallList(RIL_SOCKET_ID socket_id, int cid,
     RLOGD("requestOrSendDataCallList, cid: %d, type: %d", cid, type);
     err = at_send_command_multiline(socket_id, "AT+CGACT?", "+CGACT:", &p_response);
     if (err != 0 || p_response->success == 0) {
+        invalidateDataCallList(socket_id);
         if (t != NULL) {
             RIL_onRequestComplete(*t, RIL_E_GENERIC_FAILURE, NULL, 0);
         } else {
@@ -1294,6 +1403,7 @@ static void requestOrSendDataCallList(RIL_SOCKET_ID socket_id, int cid,
     err = at_send_command_multiline(socket_id, "AT+CGDCONT?",
                                     "+CGDCONT:", &p_response);
     if (err != 0 || p_response->success == 0) {
+        invalidateDataCallList(socket_id);
         if (t != NULL) {
             RIL_onRequestComplete(*t, RIL_E_GENERIC_FAILURE, NULL, 0);
         } else {
@@ -1339,7 +1449,7 @@ static void requestOrSendDataCallList(RIL_SOCKET_ID socket_id, int cid,
         err = at_tok_nextstr(&line, &out);
         if (err < 0) goto error;
 
-        property_get(MODEM_ETH_PROP, eth, "veth");
+        getCachedProp(MODEM_ETH_PROP, eth, "veth");
 
         int ethIndex = getEthIndexBySocketId(socket_id, ncid);
 
@@ -1504,6 +1614,7 @@ static void requestOrSendDataCallList(RIL_SOCKET_ID socket_id, int cid,
 
     if (type == SETUP_DATA_CALL) {
         RLOGD("requestOrSendDataCallList is called by SetupDataCall!");
+        invalidateDataCallList(socket_id);
         bool success = false;
         i = cid - 1;
         if (responses[i].cid == cid) {
@@ -1542,15 +1653,21 @@ static void requestOrSendDataCallList(RIL_SOCKET_ID socket_id, int cid,
         s_LTEDetached[socket_id] = false;
         s_curCid[socket_id] = 0;
     } else if (type == GET_DATA_CALL) {
+        updateDataCallList(socket_id, responses, n);
         RIL_onRequestComplete(*t, RIL_E_SUCCESS, responses,
                 n * sizeof(RIL_SetupDataCallResult_v1_4));
     } else if (type == UNSOLICTED_DATA_CALL) {
+        if (!updateDataCallList(socket_id, responses, n)) {
+            RLOGD("data call list not changed, skip unsol response");
+            return;
+        }
         RIL_onUnsolicitedResponse(RIL_UNSOL_DATA_CALL_LIST_CHANGED,
                 responses, n * sizeof(RIL_SetupDataCallResult_v1_4), socket_id);
     }
     return;
 
 error:
+    invalidateDataCallList(socket_id);
     if (t != NULL) {
         RIL_onRequestComplete(*t, RIL_E_GENERIC_FAILURE, NULL, 0);
     } else {
@@ -2475,7 +2592,7 @@ void requestSwitchUsbShare(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
 
     //  Get the property of usbtethering
     char prop[PROPERTY_VALUE_MAX] = {0};
-    property_get(RIL_USB_TETHER_FLAG, prop, "0");
+    getCachedProp(RIL_USB_TETHER_FLAG, prop, "0");
 
     if (1 == mode && !strcmp(prop, "0")) {  //  turn on usb share
         snprintf(cmd, sizeof(cmd), "AT+SPASENGMD=\"#dsm_usb_share_enable\", 1");
@@ -2491,9 +2608,9 @@ void requestSwitchUsbShare(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
         RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
     } else {
         if (1 == mode) {
-            property_set(RIL_USB_TETHER_FLAG, "1");
+            setCachedProp(RIL_USB_TETHER_FLAG, "1");
         } else {
-            property_set(RIL_USB_TETHER_FLAG, "0");
+            setCachedProp(RIL_USB_TETHER_FLAG, "0");
             pthread_mutex_lock(&s_usbSharedMutex);
             s_rxBytes = 0;
             s_txBytes = 0;
@@ -2523,11 +2640,11 @@ int processDataRequest(int request, void *data, size_t datalen, RIL_Token t,
     switch (request) {
         case RIL_REQUEST_SETUP_DATA_CALL: {
         //  Get the property of usbtethering
-            property_get(USB_TETHER_ENABLE, prop, "0");
+            getCachedProp(USB_TETHER_ENABLE, prop, "0");
 
             //  Get ril the property of usbtethering
             char ril_prop[PROPERTY_VALUE_MAX] = {0};
-            property_get(RIL_USB_TETHER_FLAG, ril_prop, "0");
+            getCachedProp(RIL_USB_TETHER_FLAG, ril_prop, "0");
 
             if (!strcmp(prop, "1") && !strcmp(ril_prop, "0")) {
                 snprintf(cmd, sizeof(cmd), "AT+SPASENGMD=\"#dsm_usb_share_enable\", 1");
@@ -2535,7 +2652,7 @@ int processDataRequest(int request, void *data, size_t datalen, RIL_Token t,
                 if (err < 0 || p_response->success == 0) {
                     RLOGD("turn on Failed");
                 } else {
-                    property_set(RIL_USB_TETHER_FLAG, "1");
+                    setCachedProp(RIL_USB_TETHER_FLAG, "1");
                     RLOGD("turn on successully");
                 }
              } else if (!strcmp(prop, "0") && !strcmp(ril_prop, "1")) {
@@ -2544,7 +2661,7 @@ int processDataRequest(int request, void *data, size_t datalen, RIL_Token t,
                  if (err < 0 || p_response->success == 0) {
                      RLOGD("turn off Failed");
                  } else {
-                     property_set(RIL_USB_TETHER_FLAG, "0");
+                     setCachedProp(RIL_USB_TETHER_FLAG, "0");
                      RLOGD("turn off successully");
                      pthread_mutex_lock(&s_usbSharedMutex);
                      s_rxBytes = 0;
@@ -2616,6 +2733,7 @@ int processDataRequest(int request, void *data, size_t datalen, RIL_Token t,
             break;
         }
         case RIL_REQUEST_DEACTIVATE_DATA_CALL:
+            invalidateDataCallList(socket_id);
             deactivateDataConnection(socket_id, data, datalen, t);
 #if (SIM_COUNT == 2)
             if (s_dataAllowed[socket_id] == 0 && !isExistActivePdp(socket_id)) {
@@ -3212,7 +3330,7 @@ int processDataUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
 
                         //modify for bug1594431
                         char prop[PROPERTY_VALUE_MAX] = {0};
-                        property_get(MODEM_ETH_PROP, prop, "veth");
+                        getCachedProp(MODEM_ETH_PROP, prop, "veth");
                         downNetcard(cid, prop, socket_id);
 
                         //modify for bug1564183
@@ -4015,7 +4133,7 @@ int dispose_data_fallback(int masterCid, int secondaryCid, RIL_SOCKET_ID socket_
         return 0;
     }
     masterEthIndex = getEthIndexBySocketId(socket_id, masterCid);
-    property_get(MODEM_ETH_PROP, prop, "veth");
+    getCachedProp(MODEM_ETH_PROP, prop, "veth");
     RLOGD("master ip type %d, secondary ip type %d",
              pdp_info[master_index].ip_state,
              pdp_info[secondary_index].ip_state);
@@ -4201,7 +4319,7 @@ static int upNetInterface(int cidIndex, IPType ipType, RIL_SOCKET_ID socket_id)
     memset(ip2, 0, sizeof(ip2));
     memset(dns1, 0, sizeof(dns1));
     memset(dns2, 0, sizeof(dns2));
-    property_get(MODEM_ETH_PROP, prop, "veth");
+    getCachedProp(MODEM_ETH_PROP, prop, "veth");
 
     /* set net interface name */
     snprintf(linker, sizeof(linker), "%s%d", prop, getEthIndexBySocketId( socket_id, cidIndex + 1));
@@ -4270,7 +4388,7 @@ static int upNetInterface(int cidIndex, IPType ipType, RIL_SOCKET_ID socket_id)
 
     char bip[PROPERTY_VALUE_MAX];
     memset(bip, 0, sizeof(bip));
-    property_get(BIP_OPENCHANNEL, bip, "0");
+    getCachedProp(BIP_OPENCHANNEL, bip, "0");
     if (strcmp(bip, "1") == 0) {
         if (ipType == IPV4) {
             in_addr_t address = inet_addr(pdp_info[cidIndex].ipladdr);
@@ -4348,7 +4466,7 @@ int cgcontrdp_set_cmd_rsp(ATResponse *p_response, RIL_SOCKET_ID socket_id) {
     memset(dns1, 0, sizeof(dns1));
     memset(dns2, 0, sizeof(dns2));
 
-    property_get(MODEM_ETH_PROP, prop, "veth");
+    getCachedProp(MODEM_ETH_PROP, prop, "veth");
 
     for (p_cur = p_response->p_intermediates; p_cur != NULL;
          p_cur = p_cur->p_next) {
@@ -4537,7 +4655,7 @@ void checkIpv6Dns(RIL_SOCKET_ID socket_id, int cid) {
     char ipTypeProp[PROPERTY_VALUE_MAX] = {0};
     char dns1[PROPERTY_VALUE_MAX] = {0};
     char dns2[PROPERTY_VALUE_MAX] = {0};
-    property_get(MODEM_ETH_PROP, ethProp, "veth");
+    getCachedProp(MODEM_ETH_PROP, ethProp, "veth");
 
     snprintf(cmd, sizeof(cmd), "vendor.net.%s%d.ip_type", ethProp, cid - 1);
     property_get(cmd, ipTypeProp, "0");
@@ -4665,7 +4783,7 @@ void cgact_deact_cmd_rsp(int cid, RIL_SOCKET_ID socket_id) {
     pdp_info[cid - 1].state = PDP_STATE_IDLE;
 
 //    usleep(200 * 1000);
-    property_get(MODEM_ETH_PROP, prop, "veth");
+    getCachedProp(MODEM_ETH_PROP, prop, "veth");
 
      if (s_isGCFTest && s_isPPPDStart) { //only for GCF test
         RLOGD("stop pppd!");
@@ -4705,7 +4823,7 @@ int requestSetupDataConnection(RIL_SOCKET_ID socket_id, void *data,
     } else {
         pdpType = "IP";
     }
-    property_set(BIP_OPENCHANNEL, "1");
+    setCachedProp(BIP_OPENCHANNEL, "1");
     s_openchannelCid = -1;
     queryAllActivePDNInfos(socket_id);
     if (s_activePDN > 0) {
@@ -4746,7 +4864,7 @@ void requestDeactiveDataConnection(RIL_SOCKET_ID socket_id, void *data,
     int cid = atoi(p_cid);
 
     RLOGD("close channel cid = %d", cid);
-    property_set(BIP_OPENCHANNEL, "0");
+    setCachedProp(BIP_OPENCHANNEL, "0");
     if (cid > 0) {
         RLOGD("close channel state for socket_id = %d is %d",
                 socket_id, s_openchannelInfo[socket_id][cid - 1].state);
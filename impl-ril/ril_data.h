@@ -31,6 +31,7 @@
 #define PROPERTY_NAME_MAX           32
 #define FILE_BUFFER_LENGTH          1024
 #define NET_INTERFACE_LENGTH        128
+#define DATA_CALL_DIGEST_LEN        4096
 
 #define PDP_STATE_IDLE              1
 #define PDP_STATE_ACTING            2
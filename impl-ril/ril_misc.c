@@ -35,6 +35,10 @@ pthread_cond_t s_vsimSocketCond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t s_screenMutex = PTHREAD_MUTEX_INITIALIZER;
 struct timeval s_timevalCloseVsim = {60, 0};
 
+/* IMEI is read from the modem on first use and kept until it resets */
+static char s_imei[SIM_COUNT][ARRAY_SIZE];
+static pthread_mutex_t s_imeiMutex = PTHREAD_MUTEX_INITIALIZER;
+
 // for SignalStrength Reporting Criteria to default
 RIL_Ext_SignalStrengthReportingCriteria s_GSMDefault[3] = {
         {0,    1, 0, (int*)-1, 1, 1, 1},
@@ -60,6 +64,40 @@ RIL_Ext_SignalStrengthReportingCriteria s_NRDefault[3] = {
         {3000, 3, 0, (int*)-1, 1, 6, 6}
 };
 
+void onModemReset_Misc() {
+    pthread_mutex_lock(&s_imeiMutex);
+    memset(s_imei, 0, sizeof(s_imei));
+    pthread_mutex_unlock(&s_imeiMutex);
+}
+
+/* copies the IMEI into imei, returns -1 if the modem can't report it */
+int getIMEI(RIL_SOCKET_ID socket_id, char *imei, size_t len) {
+    int err = -1;
+    ATResponse *p_response = NULL;
+
+    pthread_mutex_lock(&s_imeiMutex);
+    if (s_imei[socket_id][0] != '\0') {
+        snprintf(imei, len, "%s", s_imei[socket_id]);
+        pthread_mutex_unlock(&s_imeiMutex);
+        return 0;
+    }
+    pthread_mutex_unlock(&s_imeiMutex);
+
+    err = at_send_command_numeric(socket_id, "AT+CGSN", &p_response);
+    if (err < 0 || p_response->success == 0) {
+        at_response_free(p_response);
+        return -1;
+    }
+
+    pthread_mutex_lock(&s_imeiMutex);
+    snprintf(s_imei[socket_id], ARRAY_SIZE, "%s",
+             p_response->p_intermediates->line);
+    pthread_mutex_unlock(&s_imeiMutex);
+    snprintf(imei, len, "%s", p_response->p_intermediates->line);
+    at_response_free(p_response);
+    return 0;
+}
+
 static void requestBasebandVersion(RIL_SOCKET_ID socket_id, void *data,
                                    size_t datalen, RIL_Token t) {
     RIL_UNUSED_PARM(data);
@@ -165,18 +203,11 @@ static void requestDeviceIdentify(RIL_SOCKET_ID socket_id, void *data,
     memset(buf, 0, 4 * ARRAY_SIZE);
 
     // get IMEI
-    err = at_send_command_numeric(socket_id, "AT+CGSN",
-                                  &p_response);
-
-    if (err < 0 || p_response->success == 0) {
+    if (getIMEI(socket_id, buf[0], ARRAY_SIZE) < 0) {
         goto error;
     }
-
-    snprintf(buf[0], ARRAY_SIZE, "%s", p_response->p_intermediates->line);
     response[0] = buf[0];
 
-    AT_RESPONSE_FREE(p_response);
-
     // get IMEISV
     err = at_send_command_singleline(socket_id, "AT+SGMR=0,0,2",
                                      "+SGMR:", &p_response);
@@ -916,6 +947,7 @@ void requestSendAT(RIL_SOCKET_ID socket_id, const char *data, size_t datalen,
         snprintf(atResp, responseLen, "%s", response[0]);
         return;
     } else if (!strncasecmp(ATcmd, "SIM Hot Plug In", strlen("SIM Hot Plug In"))) {
+        invalidateCardStatus(socket_id);
         err = at_send_command(socket_id, "AT+SFUN=2", NULL);
 
         RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_SIM_STATUS_CHANGED,
@@ -924,6 +956,7 @@ void requestSendAT(RIL_SOCKET_ID socket_id, const char *data, size_t datalen,
                                   NULL, 0, socket_id);
         return;
     } else if (!strncasecmp(ATcmd, "SIM Hot Plug Out", strlen("SIM Hot Plug Out"))) {
+        invalidateCardStatus(socket_id);
         err = at_send_command(socket_id, "AT+SFUN=3", NULL);
 
         RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_SIM_STATUS_CHANGED,
@@ -951,6 +984,8 @@ void requestSendAT(RIL_SOCKET_ID socket_id, const char *data, size_t datalen,
             s_imsInitISIM[socket_id] = -1;
             setStkServiceRunning(socket_id, false);
         }
+        invalidateSimIoCache(socket_id, SIM_IO_CACHE_ALL_FILES);
+        invalidateCardStatus(socket_id);
         RIL_onUnsolicitedResponse(RIL_UNSOL_SIM_REFRESH, response,
                 sizeof(RIL_SimRefreshResponse_v7), socket_id);
         return;
@@ -1292,17 +1327,13 @@ int processMiscRequests(int request, void *data, size_t datalen, RIL_Token t,
             requestBasebandVersion(socket_id, data, datalen, t);
             break;
         case RIL_REQUEST_GET_IMEI: {
-            err = at_send_command_numeric(socket_id, "AT+CGSN",
-                                          &p_response);
-
-            if (err < 0 || p_response->success == 0) {
+            char imei[ARRAY_SIZE] = {0};
+            if (getIMEI(socket_id, imei, sizeof(imei)) < 0) {
                 RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
             } else {
-                RIL_onRequestComplete(
-                    t, RIL_E_SUCCESS, p_response->p_intermediates->line,
-                    strlen(p_response->p_intermediates->line) + 1);
+                RIL_onRequestComplete(t, RIL_E_SUCCESS, imei,
+                                      strlen(imei) + 1);
             }
-            at_response_free(p_response);
             break;
         }
         case RIL_REQUEST_GET_IMEISV:
@@ -16,6 +16,8 @@ int processPropRequests(int request, void *data, size_t datalen, RIL_Token t);
 int processMiscUnsolicited(RIL_SOCKET_ID socket_id, const char *s);
 void sendCmdSync(int phoneId, char *cmd, char *response, int responseLen);
 void sendSignalStrengthCriteriaCommend(RIL_SOCKET_ID socket_id, int commend);
+void onModemReset_Misc();
+int getIMEI(RIL_SOCKET_ID socket_id, char *imei, size_t len);
 extern int s_smart5GEnable;
 
 void dispatchSPBANDSCAN(RIL_Token t, void *data, void *resp);
@@ -295,7 +295,7 @@ void initWorkMode() {
 
     for (simId = RIL_SOCKET_1; simId < SIM_COUNT; simId++) {
         memset(prop, 0, sizeof(prop));
-        getProperty(simId, MODEM_WORKMODE_PROP, prop, "10");
+        getCachedSimProp(simId, MODEM_WORKMODE_PROP, prop, "10");
         s_workMode[simId] = atoi(prop);
         workMode[simId] = s_workMode[simId];
     }
@@ -1696,7 +1696,7 @@ static void requestRadioPower(RIL_SOCKET_ID socket_id, void *data, size_t datale
     assert(datalen >= sizeof(int *));
     radioState = ((int *)data)[0];
 
-    getProperty(socket_id, MODEM_ENABLED_PROP, modemEnabledProp, "1");
+    getCachedSimProp(socket_id, MODEM_ENABLED_PROP, modemEnabledProp, "1");
 
     if (radioState == 0) {
         getSIMStatus(false, socket_id);
@@ -1733,7 +1733,7 @@ static void requestRadioPower(RIL_SOCKET_ID socket_id, void *data, size_t datale
             pthread_mutex_unlock(&s_simBusy[socket_id].s_sim_busy_mutex);
         }
         initSIMPresentState();
-        getProperty(socket_id, SIM_ENABLED_PROP, simEnabledProp, "1");
+        getCachedSimProp(socket_id, SIM_ENABLED_PROP, simEnabledProp, "1");
         if (strcmp(simEnabledProp, "0") == 0) {
             RLOGE("sim enable false,radio power on failed");
             goto error;
@@ -1761,7 +1761,7 @@ static void requestRadioPower(RIL_SOCKET_ID socket_id, void *data, size_t datale
                 RIL_onRequestComplete(t, RIL_E_SUCCESS, NULL, 0);
                 return;
             } else {
-                getProperty(1 - socket_id, SIM_ENABLED_PROP, simEnabledProp, "1");
+                getCachedSimProp(1 - socket_id, SIM_ENABLED_PROP, simEnabledProp, "1");
                 if (socket_id != s_multiModeSim && !strcmp(simEnabledProp, "1")) {
                     if (s_radioState[1 - socket_id] == RADIO_STATE_OFF ||
                             s_radioState[1 - socket_id] == RADIO_STATE_UNAVAILABLE) {
@@ -1915,7 +1915,7 @@ static void requestGetModemStatus(RIL_SOCKET_ID socket_id, void *data, size_t da
     RIL_UNUSED_PARM(datalen);
 
     char prop[PROPERTY_VALUE_MAX] = {0};
-    getProperty(socket_id, MODEM_ENABLED_PROP, prop, "1");
+    getCachedSimProp(socket_id, MODEM_ENABLED_PROP, prop, "1");
 
     int isOn = atoi(prop);
     RIL_onRequestComplete(t, RIL_E_SUCCESS, &isOn, sizeof(int));
@@ -5438,11 +5438,9 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
         RLOGD("SA/NSA mode: %d", s_isSA[socket_id]);
     } else if (strStartsWith(s, "+CIREGU:")) {
         int response;
-        char *tmp = NULL;
-        line = strdup(s);
-        tmp = line;
-        at_tok_start(&tmp);
-        err = at_tok_nextint(&tmp, &response);
+        ATCursor cur;
+        at_cursor_start(&cur, s);
+        err = at_cursor_nextint(&cur, &response);
         if (err < 0) {
             RLOGD("%s fail", s);
             goto out;
@@ -5455,24 +5453,12 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
         int cid;
         int type;
         int active;
-        char *tmp;
-        line = strdup(s);
-        tmp = line;
+        ATCursor cur;
 
-        at_tok_start(&tmp);
-        err = at_tok_nextint(&tmp, &cid);
+        at_cursor_start(&cur, s);
+        err = at_cursor_scan(&cur, "int,int,int", &cid, &type, &active);
         if (err < 0) {
-            RLOGD("get cid fail");
-            goto out;
-        }
-        err = at_tok_nextint(&tmp, &type);
-        if (err < 0) {
-            RLOGD("get type fail");
-            goto out;
-        }
-        err = at_tok_nextint(&tmp, &active);
-        if (err < 0) {
-            RLOGD("get active fail");
+            RLOGD("%s: bad field %d", s, cur.field);
             goto out;
         }
 
@@ -5515,26 +5501,16 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
 #endif
     } else if (strStartsWith(s, "+SPNWNAME:")) {
         /* NITZ operator name */
-        char *tmp = NULL;
-        char *mcc = NULL;
-        char *mnc = NULL;
-        char *fullName = NULL;
-        char *shortName = NULL;
-
-        line = strdup(s);
-        tmp = line;
-        at_tok_start(&tmp);
-
-        err = at_tok_nextstr(&tmp, &mcc);
-        if (err < 0) goto out;
-
-        err = at_tok_nextstr(&tmp, &mnc);
-        if (err < 0) goto out;
-
-        err = at_tok_nextstr(&tmp, &fullName);
-        if (err < 0) goto out;
-
-        err = at_tok_nextstr(&tmp, &shortName);
+        char mcc[ARRAY_SIZE] = {0};
+        char mnc[ARRAY_SIZE] = {0};
+        char fullName[ARRAY_SIZE] = {0};
+        char shortName[ARRAY_SIZE] = {0};
+        ATCursor cur;
+
+        at_cursor_start(&cur, s);
+        err = at_cursor_scan(&cur, "str,str,str,str", mcc, sizeof(mcc),
+                mnc, sizeof(mnc), fullName, sizeof(fullName),
+                shortName, sizeof(shortName));
         if (err < 0) goto out;
 
         char nitzOperatorInfo[PROPERTY_VALUE_MAX] = {0};
@@ -5558,13 +5534,10 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
                                   NULL, 0, socket_id);
     } else if (strStartsWith(s, "+SPTESTMODE:")) {
         int response;
-        char *tmp = NULL;
-
-        line = strdup(s);
-        tmp = line;
-        at_tok_start(&tmp);
+        ATCursor cur;
 
-        err = at_tok_nextint(&tmp, &response);
+        at_cursor_start(&cur, s);
+        err = at_cursor_nextint(&cur, &response);
         if (err < 0) goto out;
 
         const char *cmd = "+SPTESTMODE:";
@@ -5594,13 +5567,10 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
         }
     } else if (strStartsWith(s, "+SPCTEC:")) {
         int response;
-        char *tmp = NULL;
-
-        line = strdup(s);
-        tmp = line;
-        at_tok_start(&tmp);
+        ATCursor cur;
 
-        err = at_tok_nextint(&tmp, &response);
+        at_cursor_start(&cur, s);
+        err = at_cursor_nextint(&cur, &response);
         if (err < 0) goto out;
 
         setPhoneType(response, socket_id);
@@ -5615,16 +5585,13 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
                 (void*)&response, sizeof(int), socket_id);
     } else if (strStartsWith(s, "+SPPRLVERSION:")) {
         // Called when CDMA PRL (preferred roaming list) changes
-        char *tmp = NULL;
         int prl_version;
+        ATCursor cur;
 
-        line = strdup(s);
-        tmp = line;
-
-        err = at_tok_start(&tmp);
+        err = at_cursor_start(&cur, s);
         if (err < 0) goto out;
 
-        err = at_tok_nextint(&tmp, &prl_version);
+        err = at_cursor_nextint(&cur, &prl_version);
         if (err < 0) goto out;
 
         RIL_onUnsolicitedResponse(RIL_UNSOL_CDMA_PRL_CHANGED,
@@ -5645,9 +5612,9 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
         // +CSCON: <mode>[,<state>[,<access>[,<coreNetwork>]]]
         // mode 1 -- connected status, represents data business
         //      0 -- idle status
-        char *tmp = NULL;
         int retValue = 1;
         int currentSigConnStatus[SIM_COUNT] = {-1};
+        ATCursor cur;
 
         RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_VOICE_NETWORK_STATE_CHANGED,
                                   NULL, 0, socket_id);
@@ -5656,23 +5623,14 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
                 (RIL_SingnalConnStatus *)alloca(sizeof(RIL_SingnalConnStatus));
         memset(sigConnStatus, 0, sizeof(RIL_SingnalConnStatus));
 
-        line = strdup(s);
-        tmp = line;
-        err = at_tok_start(&tmp);
+        err = at_cursor_start(&cur, s);
         if (err < 0) goto out;
 
-        err = at_tok_nextint(&tmp, &sigConnStatus->mode);
-        if (err < 0) goto out;
-
-        if (at_tok_hasmore(&tmp)) {
-            at_tok_nextint(&tmp, &sigConnStatus->state);
-            if (at_tok_hasmore(&tmp)) {
-                at_tok_nextint(&tmp, &sigConnStatus->access);
-                if (at_tok_hasmore(&tmp)) {
-                    at_tok_nextint(&tmp, &sigConnStatus->coreNetwork);
-                }
-            }
-        }
+        /* only <mode> is mandatory, a bad optional field ends the parse */
+        err = at_cursor_scan(&cur, "int,int?,int?,int?", &sigConnStatus->mode,
+                &sigConnStatus->state, &sigConnStatus->access,
+                &sigConnStatus->coreNetwork);
+        if (err < 0 && cur.field == 0) goto out;
 
         // Need to upload the last reported data when timeout reached
         memcpy(&s_sigConnStatus[socket_id], sigConnStatus, sizeof(RIL_SingnalConnStatus));
@@ -5742,16 +5700,10 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
         }
     } else if (strStartsWith(s, "+SPNRCFGINFO:")) {
         int response[2] = {-1, -1};
-        char *tmp = NULL;
-
-        line = strdup(s);
-        tmp = line;
-        err = at_tok_start(&tmp);
+        ATCursor cur;
 
-        err = at_tok_nextint(&tmp, &response[0]);
-        if (err < 0) goto out;
-
-        err = at_tok_nextint(&tmp, &response[1]);
+        at_cursor_start(&cur, s);
+        err = at_cursor_scan(&cur, "int,int", &response[0], &response[1]);
         if (err < 0) goto out;
 
         char smartNr[PROPERTY_VALUE_MAX] = {0};
@@ -5781,13 +5733,10 @@ int processNetworkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
         }
     } else if (strStartsWith(s, "+SPSMART5G:")) {
         int response = -1;
-        char *tmp = NULL;
-
-        line = strdup(s);
-        tmp = line;
-        err = at_tok_start(&tmp);
+        ATCursor cur;
 
-        err = at_tok_nextint(&tmp, &response);
+        at_cursor_start(&cur, s);
+        err = at_cursor_nextint(&cur, &response);
         if (err < 0) goto out;
 
         if (response == 1) {
@@ -88,74 +88,110 @@ bool isCardPresentForSeService(int simId) {
     return ret;
 }
 
+/* "AT+CGLA=<sessionid>,<length>,"" plus quotes, see 3GPP TS 27.007 */
+#define CGLA_CMD_HEAD_LEN       40
+#define APDU_HEAD_LEN           4
+#define APDU_MAX_SEGMENT_LEN    255
+#define APDU_RESP_INIT_LEN      258  /* 256 bytes of data and SW1 SW2 */
+
+/* response bytes accumulated across GET RESPONSE chaining */
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t size;
+} ApduBuffer;
+
+/* returns -1 if the two chars are not a hex byte */
+static int decodeHexByte(const char *hex) {
+    uint8_t value = 0;
+
+    if (hexToBin(hex, 2, &value) < 0) return -1;
+    return value;
+}
+
+/* hex-encode head and body straight into cmd, which must be large enough */
+static void buildCglaCommand(char *cmd, int channel, const uint8_t *head,
+        size_t headLen, const uint8_t *body, size_t bodyLen) {
+    char *p = cmd + sprintf(cmd, "AT+CGLA=%d,%d,\"", channel,
+                            (int)((headLen + bodyLen) * 2));
+    p = binToHex(head, headLen, p);
+    p = binToHex(body, bodyLen, p);
+    *p++ = '"';
+    *p = '\0';
+}
+
+static bool appendApduBuffer(ApduBuffer *buf, const char *hex, size_t hexLen) {
+    size_t need = buf->len + hexLen / 2;
+
+    if (hexLen % 2 != 0) return false;
+    if (need > buf->size) {
+        size_t size = buf->size > 0 ? buf->size : APDU_RESP_INIT_LEN;
+        uint8_t *data = NULL;
+
+        while (size < need) size *= 2;
+        data = (uint8_t *)realloc(buf->data, size);
+        if (data == NULL) return false;
+        buf->data = data;
+        buf->size = size;
+    }
+    if (hexToBin(hex, hexLen, buf->data + buf->len) < 0) return false;
+    buf->len = need;
+    return true;
+}
+
 void transmitForSeService(int simId, void *data, void *response) {
     if (s_modemState != MODEM_ALIVE) {
         RLOGE("Modem is not alive, return radio_not_avaliable");
         return;
     }
 
-    int err = -1, len = 0, i = 0;
+    int err = -1, len = 0, sw2 = 0;
+    size_t respLen = 0;
+    int channel = s_channelNumber[simId];
     char *line = NULL;
-    char cmd[AT_COMMAND_LEN * 10] = {0};
-    char tmp[AT_COMMAND_LEN * 10] = {0};
-    char respBuf[71680] = {0};  // 70k
+    char *cmd = NULL;
+    uint8_t head[APDU_HEAD_LEN + 1] = {0};
     SE_APDU *apdu = (SE_APDU *)data;
     SE_APDU *resp = (SE_APDU *)response;
+    ApduBuffer respBuf = {NULL, 0, 0};
     ATResponse *p_response = NULL;
     RIL_SIM_IO_Response sr;
 
     memset(&sr, 0, sizeof(sr));
+    resp->data = NULL;
+    resp->len = 0;
+
+    cmd = (char *)malloc(CGLA_CMD_HEAD_LEN + apdu->len * 2 + APDU_HEAD_LEN * 2 + 4);
+    if (cmd == NULL) {
+        RLOGE("transmit(): malloc failed");
+        return;
+    }
+
     pthread_mutex_lock(&s_CglaCrsmMutex[simId]);
 
     if ((apdu->len == 7) && (apdu->data[4] == 0x00)) {
         // bug1068801, total apdu len is 7 bytes and fifth byte is 0x00
-        for (i = 0; i < 5; i++) {  // send first 5 bytes to cp
-            snprintf(tmp + i * 2, sizeof(tmp) - i * 2, "%02X", apdu->data[i]);
-        }
-        snprintf(cmd, sizeof(cmd), "AT+CGLA=%d,%d,\"%s\"", s_channelNumber[simId], 10, tmp);
+        buildCglaCommand(cmd, channel, apdu->data, 5, NULL, 0);  // send first 5 bytes to cp
     } else if ((apdu->len >= 262) && (apdu->data[4] == 0x00)) {
         // bug1068836, total apdu len is longer than 262 bytes and fifth byte is 0x00
-        char commonHead[16] = {0};
-        char lastHead[16] = {0};
-        int maxAPDULen = 255;
-        int removeBytes = 7;
-        int commonP3 = 0xFF;
-        int lastP3 = (apdu->len - removeBytes) % maxAPDULen;  // length of bytes in Decimal
-        int segmentNum = (apdu->len - removeBytes) / maxAPDULen;
-
-        for (int i = 0; i < 4; i++) {
-            snprintf(commonHead + i * 2, sizeof(commonHead) - i * 2, "%02X", apdu->data[i]);
-        }
-        snprintf(lastHead, sizeof(lastHead),  "%s%02X", commonHead, lastP3);
-        snprintf(commonHead + i * 2, sizeof(commonHead) - i * 2, "%02X", commonP3);
-        RLOGD("lastHead = %s", lastHead);
-
-        for (int i = 0; i < segmentNum; i++) {
-            int pOffset = 0;
-            for (int j = removeBytes; j < (removeBytes + maxAPDULen); j++) {
-                // remove first 7 bytes, loop 255 times
-                int index = maxAPDULen * i + j;  // index
-                snprintf(tmp + pOffset, sizeof(tmp) - pOffset, "%02X", apdu->data[index]);
-                pOffset += 2;
-            }
-            snprintf(cmd, sizeof(cmd), "AT+CGLA=%d,%d,\"%s%s\"", s_channelNumber[simId],
-                    10 + maxAPDULen * 2, commonHead, tmp);
+        size_t removeBytes = 7;
+        size_t lastP3 = (apdu->len - removeBytes) % APDU_MAX_SEGMENT_LEN;
+        size_t segmentNum = (apdu->len - removeBytes) / APDU_MAX_SEGMENT_LEN;
+        const uint8_t *body = apdu->data + removeBytes;
+
+        memcpy(head, apdu->data, APDU_HEAD_LEN);
+        head[APDU_HEAD_LEN] = APDU_MAX_SEGMENT_LEN;
+        for (size_t i = 0; i < segmentNum; i++) {
+            buildCglaCommand(cmd, channel, head, sizeof(head), body, APDU_MAX_SEGMENT_LEN);
             at_send_command_singleline(simId, cmd, "+CGLA:", NULL);
-            memset(tmp, 0, sizeof(tmp));
+            body += APDU_MAX_SEGMENT_LEN;
         }
 
-        for (int i = 0; i < lastP3; i++) {
-            int index = removeBytes + maxAPDULen * segmentNum + i;
-            snprintf(tmp + i * 2, sizeof(tmp) - i * 2, "%02X", apdu->data[index]);
-        }
-        snprintf(cmd, sizeof(cmd), "AT+CGLA=%d,%d,\"%s%s\"", s_channelNumber[simId],
-                 10 + lastP3 * 2, lastHead, tmp);
+        head[APDU_HEAD_LEN] = (uint8_t)lastP3;
+        RLOGD("lastHead = %02X%02X%02X%02X%02X", head[0], head[1], head[2], head[3], head[4]);
+        buildCglaCommand(cmd, channel, head, sizeof(head), body, lastP3);
     } else {
-        for (i = 0; i < (int)(apdu->len); i++) {
-            snprintf(tmp + i * 2, sizeof(tmp) - i * 2, "%02X", apdu->data[i]);
-        }
-        snprintf(cmd, sizeof(cmd), "AT+CGLA=%d,%d,\"%s\"", s_channelNumber[simId],
-                 (int)((apdu->len) * 2), tmp);
+        buildCglaCommand(cmd, channel, apdu->data, apdu->len, NULL, 0);
     }
 
 RETRY:
@@ -173,35 +209,49 @@ RETRY:
         goto error;
     }
 
-    resp->len = strlen(sr.simResponse);
-    if (strncmp(sr.simResponse, "6881", resp->len) == 0) {  // bug1063360
-        sr.simResponse = "";
-    } else if ((resp->len >= 4) &&
-                strncmp(sr.simResponse + resp->len - 4, "61", 2) == 0) {  // bug1071112
-        snprintf(cmd, sizeof(cmd), "AT+CGLA=%d,10,\"%02XC00000%s\"", s_channelNumber[simId],
-                 apdu->data[0], sr.simResponse + resp->len - 2);
-        if (resp->len > 4) {  // bug1060206
-            strncat(respBuf, sr.simResponse, resp->len - 4);
+    respLen = strlen(sr.simResponse);
+    if (strncmp(sr.simResponse, "6881", respLen) == 0) {  // bug1063360
+        respLen = 0;
+    } else if ((respLen >= 4) &&
+                strncmp(sr.simResponse + respLen - 4, "61", 2) == 0) {  // bug1071112
+        sw2 = decodeHexByte(sr.simResponse + respLen - 2);
+        if (sw2 < 0) goto error;
+        if (respLen > 4 &&  // bug1060206
+            !appendApduBuffer(&respBuf, sr.simResponse, respLen - 4)) {
+            goto error;
         }
+        head[0] = apdu->data[0];
+        head[1] = 0xC0;  // GET RESPONSE
+        head[2] = 0x00;
+        head[3] = 0x00;
+        head[4] = (uint8_t)sw2;
+        buildCglaCommand(cmd, channel, head, sizeof(head), NULL, 0);
         AT_RESPONSE_FREE(p_response);
         goto RETRY;
-    } else if ((apdu->len == 4) && (resp->len >= 4) &&
-                strncmp(sr.simResponse + resp->len - 4, "6C", 2) == 0) {  // bug1107931
-        snprintf(cmd, sizeof(cmd), "AT+CGLA=%d,10,\"%s%s\"", s_channelNumber[simId], tmp,
-                 sr.simResponse + resp->len - 2);
+    } else if ((apdu->len == 4) && (respLen >= 4) &&
+                strncmp(sr.simResponse + respLen - 4, "6C", 2) == 0) {  // bug1107931
+        sw2 = decodeHexByte(sr.simResponse + respLen - 2);
+        if (sw2 < 0) goto error;
+        head[4] = (uint8_t)sw2;
+        buildCglaCommand(cmd, channel, apdu->data, apdu->len, head + APDU_HEAD_LEN, 1);
         AT_RESPONSE_FREE(p_response);
         goto RETRY;
     }
 
-    strncat(respBuf, sr.simResponse, resp->len);
+    if (!appendApduBuffer(&respBuf, sr.simResponse, respLen)) {
+        RLOGE("transmit(): invalid response %s", sr.simResponse);
+        goto error;
+    }
 
-    resp->len = strlen(respBuf);
-    resp->data = (uint8_t *)calloc(resp->len, sizeof(uint8_t));
-    memcpy(resp->data, (uint8_t *)respBuf, (resp->len) * sizeof(uint8_t));
+    resp->data = respBuf.data;
+    resp->len = respBuf.len;
+    respBuf.data = NULL;
 
 error:
     pthread_mutex_unlock(&s_CglaCrsmMutex[simId]);
     AT_RESPONSE_FREE(p_response);
+    free(respBuf.data);
+    free(cmd);
 }
 
 SE_Status openLogicalChannelForSeService(int simId, void *data, void *resp, int *responseLen) {
@@ -11,6 +11,7 @@
 #include "ril_stk.h"
 #include "ril_call.h"
 #include "ril_network.h"
+#include "ril_misc.h"
 #include "custom/ril_custom.h"
 #include "utils.h"
 
@@ -46,6 +47,8 @@
 #define TYPE_CHAR_SIZE                          sizeof(char)
 #define READ_BINERY                             0xb0
 #define READ_RECORD                             0xb2
+#define UPDATE_BINARY                           0xd6
+#define UPDATE_RECORD                           0xdc
 #define DF_ADF                                  "3F007FFF"
 #define DF_GSM                                  "3F007F20"
 #define DF_TELECOM                              "3F007F10"
@@ -85,6 +88,19 @@
 #define IMEI_LEN                                15
 #define AIDS_COUNT                              3
 
+#define SIM_IO_CACHE_BUCKETS                    64
+#define SIM_IO_CACHE_MAX_ENTRIES                512
+#define SIM_RECORD_BATCH_SIZE                   8
+#define READ_RECORD_MODE_ABSOLUTE               4
+
+#define EFID_ADN                                0x6f3a
+#define EFID_FDN                                0x6f3b
+#define EFID_SDN                                0x6f49
+#define EFID_EXT1                               0x6f4a
+#define EFID_EXT2                               0x6f4b
+#define EFID_EXT3                               0x6f4c
+#define DF_PHONEBOOK                            "5F3A"
+
 extern int s_modemConfig;
 
 static pthread_mutex_t s_remainTimesMutex = PTHREAD_MUTEX_INITIALIZER;
@@ -215,6 +231,45 @@ pthread_mutex_t s_SPCCHOMutex[SIM_COUNT] = {  // bug1071409
 #endif
 };
 
+/* Cached SIM_IO read responses, the key is
+ * (command, fileid, p1, p2, p3, path, aid)
+ */
+typedef struct SimIoCacheEntry {
+    int command;
+    int fileid;
+    int p1;
+    int p2;
+    int p3;
+    int sw1;
+    int sw2;
+    char *path;
+    char *aid;
+    char *simResponse;
+    struct SimIoCacheEntry *next;
+} SimIoCacheEntry;
+
+static SimIoCacheEntry *s_simIoCache[SIM_COUNT][SIM_IO_CACHE_BUCKETS];
+static int s_simIoCacheCount[SIM_COUNT];
+/* bumped by every invalidation, a read answered across one isn't cached */
+static unsigned int s_simIoCacheGen[SIM_COUNT];
+static pthread_mutex_t s_simIoCacheMutex[SIM_COUNT] = {
+        PTHREAD_MUTEX_INITIALIZER
+#if (SIM_COUNT >= 2)
+       ,PTHREAD_MUTEX_INITIALIZER
+#if (SIM_COUNT >= 3)
+       ,PTHREAD_MUTEX_INITIALIZER
+#if (SIM_COUNT >= 4)
+       ,PTHREAD_MUTEX_INITIALIZER
+#endif
+#endif
+#endif
+};
+
+/* Card status answered for GET_SIM_STATUS until the SIM state changes */
+static RIL_CardStatus_v1_4 *s_cardStatus[SIM_COUNT];
+static int s_cardStatusGeneration[SIM_COUNT];
+static pthread_mutex_t s_cardStatusMutex = PTHREAD_MUTEX_INITIALIZER;
+
 static int queryFDNServiceAvailable(RIL_SOCKET_ID socket_id);
 int initISIM(RIL_SOCKET_ID socket_id);
 int readSimRecord(RIL_SOCKET_ID socket_id, RIL_SIM_IO_v6 *data, RIL_SIM_IO_Response *sr);
@@ -240,6 +295,8 @@ void onModemReset_Sim() {
         s_imsInitISIM[socket_id] = -1;
         s_simSessionId[socket_id] = -1;
         s_appType[socket_id] = 0;
+        invalidateSimIoCache(socket_id, SIM_IO_CACHE_ALL_FILES);
+        invalidateCardStatus(socket_id);
 
         if (s_simBusy[socket_id].s_sim_busy) {
             pthread_mutex_lock(&s_simBusy[socket_id].s_sim_busy_mutex);
@@ -435,6 +492,7 @@ void setSimPresent(RIL_SOCKET_ID socket_id, int hasSim) {
     s_isSimPresent[socket_id] = hasSim;
     pthread_mutex_unlock(&s_simPresentMutex);
     if (oldSimState != hasSim) {
+        invalidateCardStatus(socket_id);
         RIL_requestTimedCallback(onIccSlotStatus, NULL, NULL);
         pthread_mutex_lock(&s_presentSIMCountMutex);
         hasSim ? ++s_presentSIMCount : --s_presentSIMCount;
@@ -533,7 +591,7 @@ SimStatus getSIMStatus(int request, RIL_SOCKET_ID socket_id) {
         if (needCacheSimPin()) {
             char modemAssertProp[PROPERTY_VALUE_MAX];
 
-            getProperty(socket_id, MODEM_ASSERT_PROP, modemAssertProp, "0");
+            getCachedSimProp(socket_id, MODEM_ASSERT_PROP, modemAssertProp, "0");
             if (strcmp(modemAssertProp, "1") == 0) {
                 setProperty(socket_id, MODEM_ASSERT_PROP, "0");
 
@@ -615,7 +673,7 @@ done:
     at_response_free(p_response);
     if (ret != SIM_ABSENT) {
         char simEnabledProp[PROPERTY_VALUE_MAX] = {0};
-        getProperty(socket_id, SIM_ENABLED_PROP, simEnabledProp, "1");
+        getCachedSimProp(socket_id, SIM_ENABLED_PROP, simEnabledProp, "1");
         if (request != RIL_EXT_REQUEST_SIMMGR_GET_SIM_STATUS &&
                 strcmp(simEnabledProp, "0") == 0) {
             ret = SIM_ABSENT;
@@ -978,13 +1036,28 @@ static int getAppTypeByAidForSPCRSM(char * aid) {
     return 0;
 }
 
+static bool isSimEnabled(RIL_SOCKET_ID socket_id) {
+    char simEnabledProp[PROPERTY_VALUE_MAX] = {0};
+
+    getCachedSimProp(socket_id, SIM_ENABLED_PROP, simEnabledProp, "1");
+    return strcmp(simEnabledProp, "0") != 0;
+}
+
+static int getCardSimStatus(int request, RIL_SOCKET_ID socket_id) {
+    if (request != RIL_EXT_REQUEST_SIMMGR_GET_SIM_STATUS &&
+            !isSimEnabled(socket_id)) {
+        return SIM_ABSENT;
+    }
+    return getSIMStatus(request, socket_id);
+}
+
 /**
  * Get the current card status.
  *
  * This must be freed using freeCardStatus.
  * @return: On success returns RIL_E_SUCCESS
  */
-static int getCardStatus(int request, RIL_SOCKET_ID socket_id,
+static int getCardStatus(int request, RIL_SOCKET_ID socket_id, int sim_status,
                          RIL_CardStatus_v1_4 **pp_card_status) {
     static RIL_AppStatus app_status_array[] = {
         // SIM_ABSENT = 0
@@ -1075,16 +1148,6 @@ static int getCardStatus(int request, RIL_SOCKET_ID socket_id,
 
     RIL_CardState card_state;
     int num_apps;
-    int sim_status;
-    char simEnabledProp[PROPERTY_VALUE_MAX] = {0};
-
-    getProperty(socket_id, SIM_ENABLED_PROP, simEnabledProp, "1");
-    if (request != RIL_EXT_REQUEST_SIMMGR_GET_SIM_STATUS &&
-            strcmp(simEnabledProp, "0") == 0) {
-        sim_status = SIM_ABSENT;
-    } else {
-        sim_status = getSIMStatus(request, socket_id);
-    }
 
     if (sim_status == SIM_ABSENT) {
         card_state = RIL_CARDSTATE_ABSENT;
@@ -1251,16 +1314,7 @@ static int getCardStatusC2K(int request, RIL_SOCKET_ID socket_id,
     RIL_CardState card_state;
     RIL_AppType* app_types = NULL;
     int num_apps;
-    int sim_status;
-    char simEnabledProp[PROPERTY_VALUE_MAX] = {0};
-
-    getProperty(socket_id, SIM_ENABLED_PROP, simEnabledProp, "1");
-    if (request != RIL_EXT_REQUEST_SIMMGR_GET_SIM_STATUS &&
-            strcmp(simEnabledProp, "0") == 0) {
-        sim_status = SIM_ABSENT;
-    } else {
-        sim_status = getSIMStatus(request, socket_id);
-    }
+    int sim_status = getCardSimStatus(request, socket_id);
 
     if (sim_status == SIM_ABSENT) {
         card_state = RIL_CARDSTATE_ABSENT;
@@ -1278,7 +1332,7 @@ static int getCardStatusC2K(int request, RIL_SOCKET_ID socket_id,
     // Only one GSM app, call old function
     if (num_apps == 1 && (app_types[0] == RIL_APPTYPE_USIM || app_types[0] == RIL_APPTYPE_SIM)) {
         free(app_types);
-        return getCardStatus(request, socket_id, pp_card_status);
+        return getCardStatus(request, socket_id, sim_status, pp_card_status);
     }
 
     /* Allocate and initialize base card status. */
@@ -1362,6 +1416,88 @@ static void freeCardStatus(RIL_CardStatus_v1_4 *p_card_status) {
     free(p_card_status);
 }
 
+static RIL_CardStatus_v1_4 *dupCardStatus(const RIL_CardStatus_v1_4 *p_card_status) {
+    RIL_CardStatus_v1_4 *p_dup = calloc(1, sizeof(RIL_CardStatus_v1_4));
+
+    if (p_dup == NULL) {
+        return NULL;
+    }
+    *p_dup = *p_card_status;
+    // aid_ptr points to s_aidsForSIM, only atr and iccid are owned
+    p_dup->base.atr = p_card_status->base.atr == NULL ?
+            NULL : strdup(p_card_status->base.atr);
+    p_dup->base.iccid = p_card_status->base.iccid == NULL ?
+            NULL : strdup(p_card_status->base.iccid);
+    return p_dup;
+}
+
+/* card status in transient states must be queried again */
+static bool isCardStatusStable(RIL_SOCKET_ID socket_id,
+                               const RIL_CardStatus_v1_4 *p_card_status) {
+    const RIL_CardStatus_v6 *card = &p_card_status->base.base;
+
+    if (card->card_state == RIL_CARDSTATE_ABSENT) {
+        return !s_simBusy[socket_id].s_sim_busy;
+    }
+    return card->num_applications > 0 &&
+            card->applications[0].app_state != RIL_APPSTATE_UNKNOWN &&
+            card->applications[0].app_state != RIL_APPSTATE_DETECTED;
+}
+
+/*
+ * Get a copy of the card status snapshot.
+ * return : NULL if there is no valid snapshot
+ */
+static RIL_CardStatus_v1_4 *getCardStatusSnapshot(RIL_SOCKET_ID socket_id) {
+    RIL_CardStatus_v1_4 *p_card_status = NULL;
+
+    pthread_mutex_lock(&s_cardStatusMutex);
+    if (s_cardStatus[socket_id] != NULL) {
+        p_card_status = dupCardStatus(s_cardStatus[socket_id]);
+    }
+    pthread_mutex_unlock(&s_cardStatusMutex);
+
+    return p_card_status;
+}
+
+/* generation is the one read before the card status was queried */
+static void saveCardStatusSnapshot(RIL_SOCKET_ID socket_id, int generation,
+                                   const RIL_CardStatus_v1_4 *p_card_status) {
+    if (!isCardStatusStable(socket_id, p_card_status)) {
+        return;
+    }
+
+    pthread_mutex_lock(&s_cardStatusMutex);
+    if (generation == s_cardStatusGeneration[socket_id]) {
+        freeCardStatus(s_cardStatus[socket_id]);
+        s_cardStatus[socket_id] = dupCardStatus(p_card_status);
+    }
+    pthread_mutex_unlock(&s_cardStatusMutex);
+}
+
+static int getCardStatusGeneration(RIL_SOCKET_ID socket_id) {
+    int generation = 0;
+
+    pthread_mutex_lock(&s_cardStatusMutex);
+    generation = s_cardStatusGeneration[socket_id];
+    pthread_mutex_unlock(&s_cardStatusMutex);
+
+    return generation;
+}
+
+/* SIM state may be changed, card status must be queried from modem again */
+void invalidateCardStatus(RIL_SOCKET_ID socket_id) {
+    if ((int)socket_id < 0 || (int)socket_id >= SIM_COUNT) {
+        return;
+    }
+
+    pthread_mutex_lock(&s_cardStatusMutex);
+    s_cardStatusGeneration[socket_id]++;
+    freeCardStatus(s_cardStatus[socket_id]);
+    s_cardStatus[socket_id] = NULL;
+    pthread_mutex_unlock(&s_cardStatusMutex);
+}
+
 void setSimLockAttemptTimes(int type, int attemptTimes,
                             RIL_SOCKET_ID socketId) {
     char num[ARRAY_SIZE] = {0};
@@ -2019,11 +2155,326 @@ static bool isISIMFileId(int fileId) {
             fileId == 0x6f07  || fileId == 0x6f09 || fileId == 0x6fe5);
 }
 
+static const char *nonNullStr(const char *str) {
+    return str == NULL ? "" : str;
+}
+
+/* relative READ RECORD (next/previous) depends on the card's record pointer */
+static bool isSimIoCacheable(RIL_SIM_IO_v6 *p_args) {
+    return p_args->data == NULL && (p_args->command == READ_BINERY ||
+            (p_args->command == READ_RECORD &&
+             p_args->p2 == READ_RECORD_MODE_ABSOLUTE) ||
+            p_args->command == COMMAND_GET_RESPONSE);
+}
+
+static bool isSimIoCacheMatched(SimIoCacheEntry *entry, RIL_SIM_IO_v6 *p_args) {
+    return entry->command == p_args->command &&
+            entry->fileid == p_args->fileid &&
+            entry->p1 == p_args->p1 && entry->p2 == p_args->p2 &&
+            entry->p3 == p_args->p3 &&
+            strcmp(entry->path, nonNullStr(p_args->path)) == 0 &&
+            strcmp(entry->aid, nonNullStr(p_args->aidPtr)) == 0;
+}
+
+/* entries of the same file are in the same bucket */
+static int getSimIoCacheBucket(int fileid) {
+    return (unsigned int)fileid % SIM_IO_CACHE_BUCKETS;
+}
+
+static bool getSimIoCache(RIL_SOCKET_ID socket_id, RIL_SIM_IO_v6 *p_args,
+                          RIL_SIM_IO_Response *sr) {
+    bool found = false;
+    SimIoCacheEntry *entry = NULL;
+
+    if (!isSimIoCacheable(p_args)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&s_simIoCacheMutex[socket_id]);
+    entry = s_simIoCache[socket_id][getSimIoCacheBucket(p_args->fileid)];
+    for (; entry != NULL; entry = entry->next) {
+        if (isSimIoCacheMatched(entry, p_args)) {
+            sr->sw1 = entry->sw1;
+            sr->sw2 = entry->sw2;
+            if (entry->simResponse != NULL) {
+                sr->simResponse = strdup(entry->simResponse);
+            }
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_simIoCacheMutex[socket_id]);
+
+    return found;
+}
+
+static unsigned int getSimIoCacheGen(RIL_SOCKET_ID socket_id) {
+    unsigned int gen = 0;
+
+    pthread_mutex_lock(&s_simIoCacheMutex[socket_id]);
+    gen = s_simIoCacheGen[socket_id];
+    pthread_mutex_unlock(&s_simIoCacheMutex[socket_id]);
+    return gen;
+}
+
+/* gen is getSimIoCacheGen() from before the read was sent to the card */
+static void putSimIoCache(RIL_SOCKET_ID socket_id, RIL_SIM_IO_v6 *p_args,
+                          RIL_SIM_IO_Response *sr, unsigned int gen) {
+    int bucket = getSimIoCacheBucket(p_args->fileid);
+    const char *path = nonNullStr(p_args->path);
+    const char *aid = nonNullStr(p_args->aidPtr);
+    size_t pathLen = strlen(path) + 1;
+    size_t aidLen = strlen(aid) + 1;
+    size_t respLen = sr->simResponse == NULL ? 0 : strlen(sr->simResponse) + 1;
+    SimIoCacheEntry *entry = NULL;
+
+    if (!isSimIoCacheable(p_args) || (sr->sw1 != 0x90 && sr->sw1 != 0x91 &&
+            sr->sw1 != 0x9e && sr->sw1 != 0x9f)) {
+        return;
+    }
+
+    /* key strings and response are allocated together with the entry */
+    entry = (SimIoCacheEntry *)calloc(1, sizeof(SimIoCacheEntry) + pathLen +
+                                      aidLen + respLen);
+    if (entry == NULL) {
+        return;
+    }
+    entry->command = p_args->command;
+    entry->fileid = p_args->fileid;
+    entry->p1 = p_args->p1;
+    entry->p2 = p_args->p2;
+    entry->p3 = p_args->p3;
+    entry->sw1 = sr->sw1;
+    entry->sw2 = sr->sw2;
+    entry->path = (char *)(entry + 1);
+    memcpy(entry->path, path, pathLen);
+    entry->aid = entry->path + pathLen;
+    memcpy(entry->aid, aid, aidLen);
+    if (respLen > 0) {
+        entry->simResponse = entry->aid + aidLen;
+        memcpy(entry->simResponse, sr->simResponse, respLen);
+    }
+
+    pthread_mutex_lock(&s_simIoCacheMutex[socket_id]);
+    if (s_simIoCacheGen[socket_id] != gen) {
+        /* e.g. the modem wrote EF_SMS while the record was being read */
+        pthread_mutex_unlock(&s_simIoCacheMutex[socket_id]);
+        free(entry);
+        return;
+    }
+    if (s_simIoCacheCount[socket_id] >= SIM_IO_CACHE_MAX_ENTRIES) {
+        pthread_mutex_unlock(&s_simIoCacheMutex[socket_id]);
+        RLOGD("SIM_IO cache full, flush it");
+        invalidateSimIoCache(socket_id, SIM_IO_CACHE_ALL_FILES);
+        pthread_mutex_lock(&s_simIoCacheMutex[socket_id]);
+    }
+    entry->next = s_simIoCache[socket_id][bucket];
+    s_simIoCache[socket_id][bucket] = entry;
+    s_simIoCacheCount[socket_id]++;
+    pthread_mutex_unlock(&s_simIoCacheMutex[socket_id]);
+}
+
+/* fileId is SIM_IO_CACHE_ALL_FILES to drop the whole cache of the SIM */
+void invalidateSimIoCache(RIL_SOCKET_ID socket_id, int fileId) {
+    int i = 0;
+    SimIoCacheEntry **pp_entry = NULL;
+    SimIoCacheEntry *entry = NULL;
+
+    if ((int)socket_id < 0 || (int)socket_id >= SIM_COUNT) {
+        return;
+    }
+
+    pthread_mutex_lock(&s_simIoCacheMutex[socket_id]);
+    s_simIoCacheGen[socket_id]++;
+    for (i = 0; i < SIM_IO_CACHE_BUCKETS; i++) {
+        if (fileId != SIM_IO_CACHE_ALL_FILES && i != getSimIoCacheBucket(fileId)) {
+            continue;
+        }
+        pp_entry = &s_simIoCache[socket_id][i];
+        while (*pp_entry != NULL) {
+            entry = *pp_entry;
+            if (fileId == SIM_IO_CACHE_ALL_FILES || entry->fileid == fileId) {
+                *pp_entry = entry->next;
+                free(entry);
+                s_simIoCacheCount[socket_id]--;
+            } else {
+                pp_entry = &entry->next;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_simIoCacheMutex[socket_id]);
+}
+
+/* record EFs which are always read record by record from the first one */
+static bool isBatchRecordFile(RIL_SIM_IO_v6 *p_args) {
+    if (p_args->command != READ_RECORD || p_args->data != NULL ||
+            p_args->p2 != READ_RECORD_MODE_ABSOLUTE ||
+            isISIMFileId(p_args->fileid)) {
+        return false;
+    }
+    switch (p_args->fileid) {
+        case EFID_ADN:
+        case EFID_FDN:
+        case EFID_SMS:
+        case EFID_SDN:
+        case EFID_EXT1:
+        case EFID_EXT2:
+        case EFID_EXT3:
+            return true;
+        default:
+            // USIM phonebook files under DF_PHONEBOOK
+            return p_args->path != NULL && strstr(p_args->path, DF_PHONEBOOK) != NULL;
+    }
+}
+
+/*
+ * Get record count of the EF from the cached GET RESPONSE,
+ * which is always in SIM format.
+ * return : record count, or 0 if unknown
+ */
+static int getSimRecordCount(RIL_SOCKET_ID socket_id, RIL_SIM_IO_v6 *p_args) {
+    int count = 0;
+    SimIoCacheEntry *entry = NULL;
+    unsigned char byteRsp[RESPONSE_EF_SIZE] = {0};
+
+    pthread_mutex_lock(&s_simIoCacheMutex[socket_id]);
+    entry = s_simIoCache[socket_id][getSimIoCacheBucket(p_args->fileid)];
+    for (; entry != NULL; entry = entry->next) {
+        if (entry->command == COMMAND_GET_RESPONSE &&
+                entry->fileid == p_args->fileid &&
+                strcmp(entry->path, nonNullStr(p_args->path)) == 0 &&
+                strcmp(entry->aid, nonNullStr(p_args->aidPtr)) == 0) {
+            if (entry->simResponse != NULL &&
+                    strlen(entry->simResponse) >= RESPONSE_EF_SIZE * 2) {
+                convertHexToBin(entry->simResponse, RESPONSE_EF_SIZE * 2,
+                                (char *)byteRsp);
+                int fileSize = (byteRsp[RESPONSE_DATA_FILE_SIZE_1] << 8) +
+                        byteRsp[RESPONSE_DATA_FILE_SIZE_2];
+                int recordLen = byteRsp[RESPONSE_DATA_RECORD_LENGTH];
+                if (recordLen > 0) {
+                    count = fileSize / recordLen;
+                }
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_simIoCacheMutex[socket_id]);
+
+    return count;
+}
+
+/*
+ * Read the records following p_args->p1 with one concatenated AT command,
+ * e.g. AT+CRSM=178,28474,1,4,28;+CRSM=178,28474,2,4,28;...
+ * and fill them into SIM_IO cache.
+ */
+static void readSimRecordBatch(RIL_SOCKET_ID socket_id, RIL_SIM_IO_v6 *p_args) {
+    int err;
+    int i = 0;
+    int num = 0;
+    int offset = 0;
+    char cmd[AT_COMMAND_LEN * SIM_RECORD_BATCH_SIZE] = {0};
+    char *line = NULL;
+    char *aid = p_args->aidPtr;
+    const char *path = nonNullStr(p_args->path);
+    bool support_aid = false;
+    int appType = 0;
+    unsigned int gen = 0;
+    ATLine *p_cur = NULL;
+    ATResponse *p_response = NULL;
+    RIL_SIM_IO_v6 record = *p_args;
+    RIL_SIM_IO_Response sr;
+
+    if (!isBatchRecordFile(p_args)) {
+        return;
+    }
+    num = getSimRecordCount(socket_id, p_args) - p_args->p1 + 1;
+    if (num > SIM_RECORD_BATCH_SIZE) {
+        num = SIM_RECORD_BATCH_SIZE;
+    }
+    if (num <= 1) {
+        return;
+    }
+
+    // Bug1017151 Access DF_TELECOM files should not use CSIM AID
+    if (aid != NULL && aid[0] != '\0' && !strStartsWith(path, DF_TELECOM)) {
+        support_aid = true;
+        appType = getAppTypeByAidForSPCRSM(aid);
+    }
+    offset = snprintf(cmd, sizeof(cmd), "AT");
+    for (i = 0; i < num && offset < (int)sizeof(cmd); i++) {
+        if (support_aid) {
+            offset += snprintf(cmd + offset, sizeof(cmd) - offset,
+                    "%s+SPCRSM=%d,%d,%d,%d,%d,%c,\"%s\",%d,%d,\"%s\"",
+                    i == 0 ? "" : ";", p_args->command, p_args->fileid,
+                    p_args->p1 + i, p_args->p2, p_args->p3, '0', path,
+                    appType, (int)(strlen(aid) / 2), aid);
+        } else {
+            offset += snprintf(cmd + offset, sizeof(cmd) - offset,
+                    "%s+CRSM=%d,%d,%d,%d,%d,%c,\"%s\"",
+                    i == 0 ? "" : ";", p_args->command, p_args->fileid,
+                    p_args->p1 + i, p_args->p2, p_args->p3, '0', path);
+        }
+    }
+    if (offset >= (int)sizeof(cmd)) {
+        RLOGE("readSimRecordBatch: command too long");
+        return;
+    }
+
+    gen = getSimIoCacheGen(socket_id);
+    pthread_mutex_lock(&s_CglaCrsmMutex[socket_id]);
+    err = at_send_command_multiline(socket_id, cmd,
+            support_aid ? "+SPCRSM:" : "+CRSM:", &p_response);
+    pthread_mutex_unlock(&s_CglaCrsmMutex[socket_id]);
+    if (err < 0 || p_response->success == 0) {
+        goto out;
+    }
+
+    /* records are only cached when all of them are answered */
+    for (i = 0, p_cur = p_response->p_intermediates; p_cur != NULL;
+         p_cur = p_cur->p_next) {
+        i++;
+    }
+    if (i != num) {
+        RLOGE("readSimRecordBatch: %d responses for %d records", i, num);
+        goto out;
+    }
+
+    for (i = 0, p_cur = p_response->p_intermediates; p_cur != NULL;
+         p_cur = p_cur->p_next, i++) {
+        memset(&sr, 0, sizeof(sr));
+        line = p_cur->line;
+
+        err = at_tok_start(&line);
+        if (err < 0) break;
+
+        err = at_tok_nextint(&line, &(sr.sw1));
+        if (err < 0) break;
+
+        err = at_tok_nextint(&line, &(sr.sw2));
+        if (err < 0) break;
+
+        if (at_tok_hasmore(&line)) {
+            err = at_tok_nextstr(&line, &(sr.simResponse));
+            if (err < 0) break;
+        }
+
+        record.p1 = p_args->p1 + i;
+        putSimIoCache(socket_id, &record, &sr, gen);
+    }
+    RLOGD("readSimRecordBatch: fileid = 0x%x, record %d ~ %d", p_args->fileid,
+          p_args->p1, p_args->p1 + num - 1);
+
+out:
+    at_response_free(p_response);
+}
+
 int readSimRecord(RIL_SOCKET_ID socket_id, RIL_SIM_IO_v6 *data, RIL_SIM_IO_Response *sr) {
     int err;
     char *cmd = NULL;
     char *line = NULL;
     char pad_data = '0';
+    unsigned int gen = 0;
     ATResponse *p_response = NULL;
 
     RIL_SIM_IO_v6 *p_args = data;
@@ -2036,6 +2487,16 @@ int readSimRecord(RIL_SOCKET_ID socket_id, RIL_SIM_IO_v6 *data, RIL_SIM_IO_Respo
     if (p_args->pin2 != NULL) {
         RLOGI("Reference-ril. requestSIM_IO pin2");
     }
+    if (getSimIoCache(socket_id, p_args, sr)) {
+        return 0;
+    }
+    if (isBatchRecordFile(p_args)) {
+        readSimRecordBatch(socket_id, p_args);
+        if (getSimIoCache(socket_id, p_args, sr)) {
+            return 0;
+        }
+    }
+    gen = getSimIoCacheGen(socket_id);
     if (p_args->data == NULL) {
         if (isISIMfile) {
             if (s_simSessionId[socket_id] == -1) {
@@ -2109,6 +2570,12 @@ int readSimRecord(RIL_SOCKET_ID socket_id, RIL_SIM_IO_v6 *data, RIL_SIM_IO_Respo
     pthread_mutex_unlock(&s_CglaCrsmMutex[socket_id]);
     free(cmd);
 
+    /* after the write, even a failed one, so that reads racing with it
+     * are not cached with the old contents */
+    if (p_args->command == UPDATE_BINARY || p_args->command == UPDATE_RECORD) {
+        invalidateSimIoCache(socket_id, p_args->fileid);
+    }
+
     if (err < 0 || p_response->success == 0) {
         goto error;
     }
@@ -2164,6 +2631,7 @@ int readSimRecord(RIL_SOCKET_ID socket_id, RIL_SIM_IO_v6 *data, RIL_SIM_IO_Respo
              }
         }
     }
+    putSimIoCache(socket_id, p_args, sr, gen);
     at_response_free(p_response);
     return 0;
 
@@ -3108,6 +3576,8 @@ void requestSIMPower(RIL_SOCKET_ID socket_id, void *data, RIL_Token t) {
     int onOff = ((int *)data)[0];
     ATResponse *p_response = NULL;
 
+    invalidateSimIoCache(socket_id, SIM_IO_CACHE_ALL_FILES);
+    invalidateCardStatus(socket_id);
     if (onOff == 0) {
         err = at_send_command(socket_id, "AT+SPDISABLESIM=1",
                               NULL);
@@ -3180,22 +3650,17 @@ error:
 }
 
 static void getIMEIPassword(RIL_SOCKET_ID socket_id, char imeiPwd[]) {
-    ATResponse *p_response = NULL;
     char password[15];
+    char imei[ARRAY_SIZE] = {0};
     int i = 0;
     int j = 0;
-    int err = -1;
-    char *line = NULL;
+    char *line = imei;
     if (socket_id != RIL_SOCKET_1) return;
 
-    err = at_send_command_numeric(socket_id, "AT+CGSN",
-            &p_response);
-    if (err < 0 || p_response->success == 0) {
+    if (getIMEI(socket_id, imei, sizeof(imei)) < 0) {
         goto error;
     }
 
-    line = p_response->p_intermediates->line;
-
     if (strlen(line) != IMEI_LEN) goto error;
     while (*line != '\0') {
         if (i >= IMEI_LEN) break;
@@ -3208,11 +3673,9 @@ static void getIMEIPassword(RIL_SOCKET_ID socket_id, char imeiPwd[]) {
     }
     imeiPwd[7] = password[0];
     imeiPwd[8] = '\0';
-    at_response_free(p_response);
     return;
 error:
     RLOGE(" get IMEI failed or IMEI is not rigth");
-    at_response_free(p_response);
     return;
 }
 
@@ -3589,6 +4052,20 @@ void getConfigSlotStatus(RIL_SOCKET_ID socket_id, RIL_SimSlotStatus_V1_2 *pSimSl
     if (pSimSlotStatus == NULL) {
         return;
     }
+
+    RIL_CardStatus_v1_4 *p_card_status = getCardStatusSnapshot(socket_id);
+    if (p_card_status != NULL) {
+        pSimSlotStatus->base.cardState = p_card_status->base.base.card_state;
+        pSimSlotStatus->base.slotState = SLOT_STATE_ACTIVE;
+        // atr and iccid are handed over to slot status
+        pSimSlotStatus->base.atr = p_card_status->base.atr;
+        pSimSlotStatus->base.iccid = p_card_status->base.iccid;
+        pSimSlotStatus->base.logicalSlotId = socket_id;
+        pSimSlotStatus->eid = "";
+        free(p_card_status);
+        return;
+    }
+
     getSIMStatus(-1, socket_id);
     pSimSlotStatus->base.cardState = s_isSimPresent[socket_id];
 
@@ -3647,27 +4124,68 @@ void onIccSlotStatus(RIL_Token t) {
     }
 }
 
+/* requests after which card status snapshot is no longer valid */
+static bool isSimStateChangingRequest(int request) {
+    switch (request) {
+        case RIL_REQUEST_ENTER_SIM_PIN:
+        case RIL_REQUEST_ENTER_SIM_PUK:
+        case RIL_REQUEST_ENTER_SIM_PIN2:
+        case RIL_REQUEST_ENTER_SIM_PUK2:
+        case RIL_REQUEST_CHANGE_SIM_PIN:
+        case RIL_REQUEST_CHANGE_SIM_PIN2:
+        case RIL_REQUEST_ENTER_NETWORK_DEPERSONALIZATION:
+        case RIL_REQUEST_SET_FACILITY_LOCK:
+        case RIL_EXT_REQUEST_SET_FACILITY_LOCK_FOR_USER:
+        case RIL_EXT_REQUEST_INIT_ISIM:
+        case RIL_EXT_REQUEST_SIMMGR_SIM_POWER:
+        case RIL_EXT_REQUEST_SIM_POWER_REAL:
+        case RIL_REQUEST_SET_SIM_CARD_POWER:
+        case RIL_REQUEST_CONFIG_SET_SLOT_MAPPING:
+            return true;
+        default:
+            return false;
+    }
+}
+
 int processSimRequests(int request, void *data, size_t datalen, RIL_Token t,
                        RIL_SOCKET_ID socket_id) {
     int err;
     ATResponse *p_response = NULL;
+    bool isStateChanging = isSimStateChangingRequest(request);
+
+    if (isStateChanging) {
+        invalidateCardStatus(socket_id);
+    }
 
     switch (request) {
         case RIL_REQUEST_GET_SIM_STATUS:
         case RIL_EXT_REQUEST_SIMMGR_GET_SIM_STATUS: {
-            RIL_CardStatus_v1_4 *p_card_status;
+            RIL_CardStatus_v1_4 *p_card_status = NULL;
             char *p_buffer;
             int buffer_size;
-            sem_wait(&(s_sem[socket_id]));
-            int result;
-            // To support C2K multi app card status
-            if (s_isModemSupportCDMA) {
-                result = getCardStatusC2K(request, socket_id, &p_card_status);
-            } else {
-                result = getCardStatus(request, socket_id, &p_card_status);
+            int result = RIL_E_SUCCESS;
+            // SIM disabled is reported as absent by GET_SIM_STATUS only
+            bool useSnapshot = isSimEnabled(socket_id);
+
+            if (useSnapshot) {
+                p_card_status = getCardStatusSnapshot(socket_id);
             }
+            if (p_card_status == NULL) {
+                int generation = getCardStatusGeneration(socket_id);
+                sem_wait(&(s_sem[socket_id]));
+                // To support C2K multi app card status
+                if (s_isModemSupportCDMA) {
+                    result = getCardStatusC2K(request, socket_id, &p_card_status);
+                } else {
+                    result = getCardStatus(request, socket_id,
+                            getCardSimStatus(request, socket_id), &p_card_status);
+                }
 
-            sem_post(&(s_sem[socket_id]));
+                sem_post(&(s_sem[socket_id]));
+                if (useSnapshot && result == RIL_E_SUCCESS) {
+                    saveCardStatusSnapshot(socket_id, generation, p_card_status);
+                }
+            }
 
             if (result == RIL_E_SUCCESS) {
                 p_buffer = (char *)p_card_status;
@@ -3917,6 +4435,9 @@ int processSimRequests(int request, void *data, size_t datalen, RIL_Token t,
             return 0;
     }
 
+    if (isStateChanging) {
+        invalidateCardStatus(socket_id);
+    }
     return 1;
 }
 
@@ -3934,6 +4455,8 @@ void onSimStatusChanged(RIL_SOCKET_ID socket_id, const char *s) {
     if (err < 0) goto out;
 
     if (type == 3) {
+        invalidateSimIoCache(socket_id, SIM_IO_CACHE_ALL_FILES);
+        invalidateCardStatus(socket_id);
         if (at_tok_hasmore(&tmp)) {
             err = at_tok_nextint(&tmp, &value);
             if (err < 0) goto out;
@@ -3989,6 +4512,7 @@ int processSimUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
         err = at_tok_nextint(&tmp, &simID);
         if (err < 0) goto out;
 
+        invalidateCardStatus(socket_id);
         RIL_onUnsolicitedResponse(RIL_EXT_UNSOL_SIMLOCK_SIM_EXPIRED, &simID,
                 sizeof(simID), socket_id);
     } else if (strStartsWith(s, "+CLCK:")) {
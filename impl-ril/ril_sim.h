@@ -12,6 +12,9 @@
 #define PHONE_COUNT_PROP         "persist.vendor.radio.phone_count"
 #define SIM_SLOT_MAPPING_PROP    "persist.vendor.radio.sim.slot.mapping"
 
+#define SIM_IO_CACHE_ALL_FILES   -1
+#define EFID_SMS                 0x6f3c
+
 typedef enum {
     UNLOCK_PIN   = 0,
     UNLOCK_PIN2  = 1,
@@ -77,4 +80,6 @@ void dispatchCLCK(RIL_Token t, void *data, void *resp);
 void setSimPresent(RIL_SOCKET_ID socket_id, int hasSim);
 int isSimPresent(RIL_SOCKET_ID socket_id);
 void initSIMPresentState();
+void invalidateSimIoCache(RIL_SOCKET_ID socket_id, int fileId);
+void invalidateCardStatus(RIL_SOCKET_ID socket_id);
 #endif  // RIL_SIM_H_
@@ -13,17 +13,124 @@
 
 #define LOG_BUF_SIZE            512
 
+/* AT+CMMS <n>, 3GPP TS 27.005 3.5.6 */
+#define CMMS_DISABLE            0
+#define CMMS_KEEP_ENABLED       2
+
+/* a multipart send the framework abandoned releases the link after this */
+#define CMMS_IDLE_TIMEOUT_MSEC  10000
+
+/* both guarded by s_moreMsgsMutex, idle deadline is 0 while none is armed */
+static int s_moreMsgsToSend[SIM_COUNT] = {CMMS_DISABLE};
+static long long s_moreMsgsIdleMsec[SIM_COUNT];
+static pthread_mutex_t s_moreMsgsMutex[SIM_COUNT] = {
+        PTHREAD_MUTEX_INITIALIZER
+#if (SIM_COUNT >= 2)
+        ,PTHREAD_MUTEX_INITIALIZER
+#if (SIM_COUNT >= 3)
+        ,PTHREAD_MUTEX_INITIALIZER
+#if (SIM_COUNT >= 4)
+        ,PTHREAD_MUTEX_INITIALIZER
+#endif
+#endif
+#endif
+};
+
 void onModemReset_Sms() {
-    ;
+    int simId = 0;
+
+    for (simId = 0; simId < SIM_COUNT; simId++) {
+        pthread_mutex_lock(&s_moreMsgsMutex[simId]);
+        s_moreMsgsToSend[simId] = CMMS_DISABLE;
+        s_moreMsgsIdleMsec[simId] = 0;
+        pthread_mutex_unlock(&s_moreMsgsMutex[simId]);
+    }
+}
+
+/* called with s_moreMsgsMutex held */
+static void setMoreMsgsToSendLocked(RIL_SOCKET_ID socket_id, int mode) {
+    int err;
+    char cmd[AT_COMMAND_LEN] = {0};
+    ATResponse *p_response = NULL;
+
+    s_moreMsgsIdleMsec[socket_id] = 0;
+    if (s_moreMsgsToSend[socket_id] == mode) {
+        return;
+    }
+    snprintf(cmd, sizeof(cmd), "AT+CMMS=%d", mode);
+    err = at_send_command(socket_id, cmd, &p_response);
+    if (err < 0 || p_response->success == 0) {
+        RLOGE("%s failed", cmd);
+        s_moreMsgsToSend[socket_id] = CMMS_DISABLE;
+    } else {
+        s_moreMsgsToSend[socket_id] = mode;
+    }
+    at_response_free(p_response);
+}
+
+/**
+ * Keeps the relay protocol link open between the segments of a
+ * concatenated SMS, so that the next AT+CMGS does not set it up again.
+ */
+static void setMoreMsgsToSend(RIL_SOCKET_ID socket_id, int mode) {
+    pthread_mutex_lock(&s_moreMsgsMutex[socket_id]);
+    setMoreMsgsToSendLocked(socket_id, mode);
+    pthread_mutex_unlock(&s_moreMsgsMutex[socket_id]);
+}
+
+static void onMoreMsgsIdleTimeout(void *param) {
+    RIL_SOCKET_ID socket_id = *((RIL_SOCKET_ID *)param);
+
+    pthread_mutex_lock(&s_moreMsgsMutex[socket_id]);
+    if (s_moreMsgsIdleMsec[socket_id] != 0 &&
+            getMonotonicMsec() >= s_moreMsgsIdleMsec[socket_id]) {
+        RLOGD("no more SMS segment sent, release the link");
+        setMoreMsgsToSendLocked(socket_id, CMMS_DISABLE);
+    }
+    pthread_mutex_unlock(&s_moreMsgsMutex[socket_id]);
+}
+
+/* releases the link if no other segment follows in CMMS_IDLE_TIMEOUT_MSEC */
+static void armMoreMsgsIdleTimeout(RIL_SOCKET_ID socket_id) {
+    const struct timeval timeout = {CMMS_IDLE_TIMEOUT_MSEC / 1000,
+                                    (CMMS_IDLE_TIMEOUT_MSEC % 1000) * 1000};
+
+    pthread_mutex_lock(&s_moreMsgsMutex[socket_id]);
+    if (s_moreMsgsToSend[socket_id] != CMMS_DISABLE) {
+        s_moreMsgsIdleMsec[socket_id] = getMonotonicMsec() + CMMS_IDLE_TIMEOUT_MSEC;
+    }
+    pthread_mutex_unlock(&s_moreMsgsMutex[socket_id]);
+    RIL_requestTimedCallback(onMoreMsgsIdleTimeout,
+                             (void *)&s_socketId[socket_id], &timeout);
+}
+
+/* sends AT+CMGS with <smsc><pdu> written after the "> " prompt */
+static int sendSmsPdu(RIL_SOCKET_ID socket_id, const char *smsc,
+                      const char *pdu, ATResponse **pp_outResponse) {
+    int err;
+    char cmd[AT_COMMAND_LEN] = {0};
+    char *smsPdu = NULL;
+
+    /* "NULL for default SMSC" */
+    if (smsc == NULL) {
+        smsc = "00";
+    }
+    snprintf(cmd, sizeof(cmd), "AT+CMGS=%d", (int)(strlen(pdu) / 2));
+    if (asprintf(&smsPdu, "%s%s", smsc, pdu) < 0) {
+        RLOGE("Failed to asprintf");
+        return -1;
+    }
+
+    err = at_send_command_sms(socket_id, cmd, smsPdu, "+CMGS:", pp_outResponse);
+    free(smsPdu);
+    return err;
 }
 
 static void requestSendSMS(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
-                              RIL_Token t) {
+                              RIL_Token t, bool expectMore) {
     RIL_UNUSED_PARM(datalen);
 
-    int err, ret;
-    int tpLayerLength;
-    char *cmd1 = NULL, *cmd2 = NULL;
+    int err;
     char *line = NULL;
     RIL_SMS_Response response = {0};
     ATResponse *p_response = NULL;
@@ -35,31 +142,18 @@ static void requestSendSMS(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
         RIL_onRequestComplete(t, RIL_E_SIM_ABSENT, NULL, 0);
         return;
     }
-    tpLayerLength = strlen(pdu) / 2;
 
-    /* "NULL for default SMSC" */
-    if (smsc == NULL) {
-        smsc = "00";
+    if (expectMore) {
+        setMoreMsgsToSend(socket_id, CMMS_KEEP_ENABLED);
     }
 
-    ret = asprintf(&cmd1, "AT+CMGS=%d", tpLayerLength);
-    if (ret < 0) {
-        RLOGE("Failed to asprintf");
-        FREEMEMORY(cmd1);
-        goto error1;
-    }
-    ret = asprintf(&cmd2, "%s%s", smsc, pdu);
-    if (ret < 0) {
-        RLOGE("Failed to asprintf");
-        FREEMEMORY(cmd1);
-        FREEMEMORY(cmd2);
-        goto error1;
+    err = sendSmsPdu(socket_id, smsc, pdu, &p_response);
+    if (!expectMore || err != 0 || p_response->success == 0) {
+        /* last segment sent or the sequence is broken, release the link */
+        setMoreMsgsToSend(socket_id, CMMS_DISABLE);
+    } else {
+        armMoreMsgsIdleTimeout(socket_id);
     }
-
-    err = at_send_command_sms(socket_id, cmd1, cmd2, "+CMGS:",
-                              &p_response);
-    free(cmd1);
-    free(cmd2);
     if (err != 0 || p_response->success == 0) {
         goto error;
     }
@@ -110,11 +204,9 @@ static void requestSendIMSSMS(RIL_SOCKET_ID socket_id, void *data, size_t datale
                                   RIL_Token t) {
     RIL_UNUSED_PARM(datalen);
 
-    int err, ret;
-    int tpLayerLength;
+    int err;
     char *pdu = NULL;
     char *line = NULL;
-    char *cmd1 = NULL, *cmd2 = NULL;
     const char *smsc = NULL;
     RIL_SMS_Response response;
     ATResponse *p_response = NULL;
@@ -138,32 +230,12 @@ static void requestSendIMSSMS(RIL_SOCKET_ID socket_id, void *data, size_t datale
             }
         }
 
-        tpLayerLength = strlen(pdu) / 2;
-        /* "NULL for default SMSC" */
-        if (smsc == NULL) {
-            smsc = "00";
-        }
-
-        ret = asprintf(&cmd1, "AT+CMGS=%d", tpLayerLength);
-        if (ret < 0) {
-            RLOGE("Failed to asprintf");
-            FREEMEMORY(cmd1);
-            goto error1;
-        }
-        ret = asprintf(&cmd2, "%s%s", smsc, pdu);
-        if (ret < 0) {
-            RLOGE("Failed to asprintf");
-            FREEMEMORY(cmd1);
-            FREEMEMORY(cmd2);
-            goto error1;
-        }
-
-        err = at_send_command_sms(socket_id, cmd1, cmd2, "+CMGS:",
-                                  &p_response);
-        free(cmd1);
-        free(cmd2);
-        if (err != 0 || p_response->success == 0)
+        err = sendSmsPdu(socket_id, smsc, pdu, &p_response);
+        if (err != 0 || p_response->success == 0) {
+            /* a multipart sequence the failed PDU belonged to is broken */
+            setMoreMsgsToSend(socket_id, CMMS_DISABLE);
             goto error;
+        }
 
         /* FIXME fill in messageRef and ackPDU */
         line = p_response->p_intermediates->line;
@@ -286,6 +358,7 @@ static void requestWriteSmsToSim(RIL_SOCKET_ID socket_id, void *data, size_t dat
                               &p_response);
     free(cmd);
     free(cmd1);
+    invalidateSimIoCache(socket_id, EFID_SMS);
 
     if (err < 0 || p_response->success == 0) {
         goto error;
@@ -1042,87 +1115,145 @@ error:
     return;
 }
 
+/* reads len bits starting at bit index of bytes, MSB first */
+static unsigned char getPduBits(const unsigned char *bytes, int index, int len) {
+    unsigned char dec = 0;
+    int i = 0;
+
+    for (; i < len; i++) {
+        dec = (dec << 1) | ((bytes[(index + i) / 8] >> (7 - (index + i) % 8)) & 0x01);
+    }
+    return dec;
+}
+
 /* 3GPP2 C.S0015-B 3.4.33 Address Parameters */
 void decodeCdmaSmsAddress(unsigned char* bytePdu, RIL_CDMA_SMS_Address* address, int length) {
     int index = 0;
     int chari_len = 4;
     int i = 0;
-    unsigned char* bitflow = (unsigned char*) malloc(length * 8);
+    int bits = length * 8;
 
-    for (i = 0; i < length; i ++) {
-        convertUnsignedCharToBinary(bytePdu[i], bitflow + i * 8, 8);
+    if (bits < 10) {
+        RLOGE("decodeCdmaSmsAddress: invalid length %d", length);
+        return;
     }
-
-    address->digit_mode = bitflow[index++];
-    address->number_mode = bitflow[index++];
+    address->digit_mode = getPduBits(bytePdu, index++, 1);
+    address->number_mode = getPduBits(bytePdu, index++, 1);
 
     if (address->digit_mode == RIL_CDMA_SMS_DIGIT_MODE_8_BIT) {
         //change an address digit or character into 8bits
         chari_len = 8;
         RLOGD("change an address digit or character into 8bits");
 
-        address->number_type = convertBinaryToUnsignedChar(bitflow, index, 3);
+        address->number_type = getPduBits(bytePdu, index, 3);
         index += 3;
         RLOGD("decodeCdmaSmsAddress: address->number_type = %d", address->number_type);
 
         if (address->number_mode == RIL_CDMA_SMS_NUMBER_MODE_NOT_DATA_NETWORK) {
-            address->number_plan = convertBinaryToUnsignedChar(bitflow, index, 4);
+            address->number_plan = getPduBits(bytePdu, index, 4);
             index += 4;
             RLOGD("decodeCdmaSmsAddress: address->number_plan = %d", address->number_plan);
         }
     }
 
-    address->number_of_digits = convertBinaryToUnsignedChar(bitflow, index, 8);
+    if (index + 8 > bits) {
+        RLOGE("decodeCdmaSmsAddress: no number of digits");
+        return;
+    }
+    address->number_of_digits = getPduBits(bytePdu, index, 8);
     index += 8;
+    if (address->number_of_digits > RIL_CDMA_SMS_ADDRESS_MAX ||
+        index + address->number_of_digits * chari_len > bits) {
+        RLOGE("decodeCdmaSmsAddress: invalid number_of_digits: %d",
+              address->number_of_digits);
+        address->number_of_digits = 0;
+        return;
+    }
     RLOGD("decodeCdmaSmsAddress: number_of_digits: %d", address->number_of_digits);
 
     for (i = 0; i < address->number_of_digits; i ++) {
-        address->digits[i] = convertBinaryToUnsignedChar(bitflow, index, chari_len);
+        address->digits[i] = getPduBits(bytePdu, index, chari_len);
         index += chari_len;
-        RLOGD("address->digits[%d] = 0x%2x", i, address->digits[i]);
     }
 
     RLOGD("chari_len = %d", chari_len);
-    free(bitflow);
+}
+
+#define CDMA_SMS_PARAM_MAX_LEN  255
+#define CBM_PDU_MAX_LEN         1252  /* UMTS CBS message, 3GPP TS 23.041 */
+
+/* walks a hex PDU byte by byte without decoding it into a buffer first */
+typedef struct {
+    const char *hex;
+    int length;  /* in bytes */
+    int index;
+} SmsPduReader;
+
+static int readPduByte(SmsPduReader *reader) {
+    uint8_t value = 0;
+
+    if (reader->index >= reader->length ||
+        hexToBin(reader->hex + reader->index * 2, 2, &value) < 0) {
+        return -1;
+    }
+    reader->index++;
+    return value;
+}
+
+/* decodes the next len bytes into dst, or skips them if dst is NULL */
+static bool readPduBytes(SmsPduReader *reader, unsigned char *dst, int len) {
+    if (len > reader->length - reader->index) return false;
+    if (dst != NULL && hexToBin(reader->hex + reader->index * 2, len * 2, dst) < 0) {
+        return false;
+    }
+    reader->index += len;
+    return true;
 }
 
 /*3GPP2 C.S0015-B*/
-RIL_CDMA_SMS_Message buildCdmaSmsMessage(const char *sms_pdu) {
-    RIL_CDMA_SMS_Message sms = {0};
-    int index = 2; // +CMT first 0000 don't used
+bool buildCdmaSmsMessage(const char *sms_pdu, RIL_CDMA_SMS_Message *sms) {
+    SmsPduReader reader = {sms_pdu, (int)(strlen(sms_pdu) / 2), 2};  // +CMT first 0000 don't used
     int param_id, param_len;
-    unsigned char bytePdu[AT_RESPONSE_LEN] = {0};
-    int length = 0;
-
-    convertHexToBin(sms_pdu, strlen(sms_pdu), (char *)bytePdu);
-    length = strlen(sms_pdu) / 2;
-    while (index < length) {
-        param_id = bytePdu[index++];
-        param_len = bytePdu[index++];
+    unsigned char param[CDMA_SMS_PARAM_MAX_LEN] = {0};
+
+    memset(sms, 0, sizeof(RIL_CDMA_SMS_Message));
+    while (reader.index < reader.length) {
+        param_id = readPduByte(&reader);
+        param_len = readPduByte(&reader);
+        if (param_id < 0 || param_len < 0) {
+            RLOGE("buildCdmaSmsMessage: invalid parameter at %d", reader.index);
+            return false;
+        }
 
         switch (param_id) {
         case TeleserviceIdentifier:
             if (param_len != 2) {
                 RLOGE("buildCdmaSmsMessage: get TeleserviceIdentifier failed");
-            } else {
-                sms.uTeleserviceID = (((unsigned short)bytePdu[index]) << 8)
-                                    + (unsigned short)bytePdu[index + 1];
-                RLOGD("sms.uTeleserviceID: 0x%x\n", sms.uTeleserviceID);
+                break;
             }
-            break;
+            if (!readPduBytes(&reader, param, param_len)) return false;
+            sms->uTeleserviceID = (((unsigned short)param[0]) << 8)
+                                + (unsigned short)param[1];
+            RLOGD("sms.uTeleserviceID: 0x%x\n", sms->uTeleserviceID);
+            continue;
         case ServiceCategory:
             if (param_len != 2) {
                 RLOGE("buildCdmaSmsMessage: get ServiceCategory failed");
-            } else {
-                sms.uServicecategory = (((unsigned short)bytePdu[index]) << 8)
-                                    + (unsigned short)bytePdu[index + 1];
-                RLOGD("sms.uServicecategory: 0x%x\n", sms.uServicecategory);
+                break;
             }
-            break;
+            if (!readPduBytes(&reader, param, param_len)) return false;
+            sms->uServicecategory = (((unsigned short)param[0]) << 8)
+                                  + (unsigned short)param[1];
+            RLOGD("sms.uServicecategory: 0x%x\n", sms->uServicecategory);
+            continue;
         case DestinationAddress:
         case OriginatingAddress:
-            decodeCdmaSmsAddress(bytePdu+index, &(sms.sAddress), param_len);
-            break;
+            if (!readPduBytes(&reader, param, param_len)) {
+                RLOGE("buildCdmaSmsMessage: get Address failed");
+                return false;
+            }
+            decodeCdmaSmsAddress(param, &(sms->sAddress), param_len);
+            continue;
         case OriginatingSubaddress:
         case DestinationSubaddress:
             RLOGE("buildCdmaSmsMessage: get SubAddress do not supported now...");
@@ -1134,16 +1265,23 @@ RIL_CDMA_SMS_Message buildCdmaSmsMessage(const char *sms_pdu) {
             RLOGE("buildCdmaSmsMessage: didn't decode CauseCodes");
             break;
         case BearerData:
-            sms.uBearerDataLen = param_len;
-            memcpy(sms.aBearerData, bytePdu + index, sms.uBearerDataLen);
-            break;
+            if (param_len > RIL_CDMA_SMS_BEARER_DATA_MAX ||
+                !readPduBytes(&reader, sms->aBearerData, param_len)) {
+                RLOGE("buildCdmaSmsMessage: get BearerData failed");
+                return false;
+            }
+            sms->uBearerDataLen = param_len;
+            continue;
         default:
             break;
         }
-        index += param_len;
+        if (!readPduBytes(&reader, NULL, param_len)) {
+            RLOGE("buildCdmaSmsMessage: truncated parameter 0x%x", param_id);
+            return false;
+        }
     }
 
-    return sms;
+    return true;
 }
 
 static void requestWriteCdmaSmsToRuim(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
@@ -1176,6 +1314,7 @@ static void requestWriteCdmaSmsToRuim(RIL_SOCKET_ID socket_id, void *data, size_
     err = at_send_command_sms(socket_id, cmd, pdu, "+CMGW:",
                               &p_response);
     free(cmd);
+    invalidateSimIoCache(socket_id, EFID_SMS);
 
     if (err < 0 || p_response->success == 0) {
         goto error;
@@ -1241,7 +1380,8 @@ int processSmsRequests(int request, void *data, size_t datalen, RIL_Token t,
     switch (request) {
         case RIL_REQUEST_SEND_SMS:
         case RIL_REQUEST_SEND_SMS_EXPECT_MORE:
-            requestSendSMS(socket_id, data, datalen, t);
+            requestSendSMS(socket_id, data, datalen, t,
+                           request == RIL_REQUEST_SEND_SMS_EXPECT_MORE);
             break;
         case RIL_REQUEST_IMS_SEND_SMS:
             requestSendIMSSMS(socket_id, data, datalen, t);
@@ -1262,6 +1402,7 @@ int processSmsRequests(int request, void *data, size_t datalen, RIL_Token t,
             char cmd[AT_COMMAND_LEN] = {0};
             snprintf(cmd, sizeof(cmd), "AT+CMGD=%d", ((int *)data)[0]);
             err = at_send_command(socket_id, cmd, &p_response);
+            invalidateSimIoCache(socket_id, EFID_SMS);
             if (err < 0 || p_response->success == 0) {
                 RIL_onRequestComplete(t, RIL_E_GENERIC_FAILURE, NULL, 0);
             } else {
@@ -1415,7 +1556,11 @@ int processSmsUnsolicited(RIL_SOCKET_ID socket_id, const char *s,
             RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_NEW_SMS, sms_pdu,
                                       strlen(sms_pdu), socket_id);
         } else {
-            RIL_CDMA_SMS_Message sms = buildCdmaSmsMessage(sms_pdu);
+            RIL_CDMA_SMS_Message sms;
+            if (!buildCdmaSmsMessage(sms_pdu, &sms)) {
+                RLOGE("CDMA: malformed +CMT pdu, report what was decoded");
+            }
+            /* still report it, the modem waits for +CNMA */
             RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_CDMA_NEW_SMS,
                     &sms, sizeof(RIL_CDMA_SMS_Message), socket_id);
         }
@@ -1448,6 +1593,8 @@ int processSmsUnsolicited(RIL_SOCKET_ID socket_id, const char *s,
             RLOGD("sms request arrive but it is not a new sms");
             goto out;
         }
+        /* the modem stored it in EF_SMS behind our back */
+        invalidateSimIoCache(socket_id, EFID_SMS);
 
         /* Read the memory location of the sms */
         err = at_tok_nextint(&tmp, &location);
@@ -1459,11 +1606,14 @@ int processSmsUnsolicited(RIL_SOCKET_ID socket_id, const char *s,
                                   sizeof(location), socket_id);
     } else if (strStartsWith(s, "+CBM:")) {
         int smsPDULen = (int)strlen(sms_pdu);
-        char *pdu_bin = NULL;
+        uint8_t cbmBuf[CBM_PDU_MAX_LEN];
+        uint8_t *pdu_bin = cbmBuf;
 
         RLOGD("\"%s\" len = %d, sms_pdu len = %d", s, (int)strlen(s), smsPDULen);
-        pdu_bin = (char *)calloc(smsPDULen / 2 + 1, sizeof(char));
-        if (!convertHexToBin(sms_pdu, smsPDULen, pdu_bin)) {
+        if (smsPDULen / 2 > CBM_PDU_MAX_LEN) {
+            pdu_bin = (uint8_t *)calloc(smsPDULen / 2 + 1, sizeof(uint8_t));
+        }
+        if (pdu_bin != NULL && hexToBin(sms_pdu, smsPDULen, pdu_bin) >= 0) {
             RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_NEW_BROADCAST_SMS,
                                       pdu_bin, smsPDULen / 2, socket_id);
         } else {
@@ -1477,7 +1627,9 @@ int processSmsUnsolicited(RIL_SOCKET_ID socket_id, const char *s,
                 RLOGE("%s", smsPDUTmp);
             }
         }
-        free(pdu_bin);
+        if (pdu_bin != cbmBuf) {
+            free(pdu_bin);
+        }
     } else if (strStartsWith(s, "+SPLWRN:")) {
         //  +SPLWRN:<segment_id>,<total_segments>,<length>,<CR><LF><data>
         int skip;
@@ -1546,7 +1698,7 @@ int processSmsUnsolicited(RIL_SOCKET_ID socket_id, const char *s,
              * Response data1 + data2 + ... + dataN to framework
              */
             binData = (char *)calloc(strlen(msg) / 2 + 1, sizeof(char));
-            if (!convertHexToBin(msg, strlen(msg), binData)) {
+            if (hexToBin(msg, strlen(msg), (uint8_t *)binData) >= 0) {
                 RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_NEW_BROADCAST_SMS,
                         binData, strlen(msg) / 2, socket_id);
             } else {
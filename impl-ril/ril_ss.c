@@ -29,14 +29,7 @@ void onModemReset_Ss() {
 }
 
 void convertStringToHex(char *outString, char *inString, int len) {
-    const char *hex = "0123456789ABCDEF";
-    int i = 0;
-    while (i < len) {
-        *outString++ = hex[inString[i] >> 4];
-        *outString++ = hex[inString[i] & 0x0F];
-        ++i;
-    }
-    *outString = '\0';
+    binToHex((const uint8_t *)inString, len, outString);
 }
 
 static void requestSendUSSD(RIL_SOCKET_ID socket_id, void *data, size_t datalen,
@@ -1003,6 +996,7 @@ int processSSUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
         char *response[3] = {NULL, NULL, NULL};
         char *tmp = NULL;
         char *hexStr = NULL;
+        int binLen = 0;
         char tmpStr[ARRAY_SIZE * 8] = {0};
         char utf8Str[ARRAY_SIZE * 8] = {0};
 
@@ -1032,13 +1026,17 @@ int processSSUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
                 goto out;
             }
             /* convert hex string to string */
-            convertHexToBin((const char *)hexStr, strlen(hexStr), tmpStr);
+            binLen = strlen(hexStr) / 2;
+            if (binLen > (int)sizeof(tmpStr) ||
+                hexToBin(hexStr, binLen * 2, (uint8_t *)tmpStr) < 0) {
+                RLOGE("invalid ussd string, len = %d", binLen);
+                goto out;
+            }
             if (strcmp(response[2], "15") == 0) {  // GSM_7BITS_TYPE
-                convertGsm7ToUtf8((unsigned char *)tmpStr, strlen(hexStr) / 2,
+                convertGsm7ToUtf8((unsigned char *)tmpStr, binLen,
                                   (unsigned char *)utf8Str);
             } else if (strcmp(response[2], "72") == 0) {  // UCS2_TYPE
-                convertUcs2ToUtf8((unsigned char *)tmpStr, strlen(hexStr) / 2,
-                                  (unsigned char *)utf8Str);
+                ucs2ToUtf8((uint8_t *)tmpStr, binLen, utf8Str, sizeof(utf8Str));
             }
 
             response[1] = utf8Str;
@@ -423,6 +423,12 @@ int processStkUnsolicited(RIL_SOCKET_ID socket_id, const char *s) {
             goto out;
         }
         response->result = result;
+        if (SIM_FILE_UPDATE == result) {
+            invalidateSimIoCache(socket_id, response->ef_id);
+        } else {
+            invalidateSimIoCache(socket_id, SIM_IO_CACHE_ALL_FILES);
+            invalidateCardStatus(socket_id);
+        }
         if (SIM_RESET == result) {
             s_imsInitISIM[socket_id] = -1;
             setStkServiceRunning(socket_id, false);
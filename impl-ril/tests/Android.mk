@@ -0,0 +1,35 @@
+# Host tests of common/codec.c and common/at_tok.c, and a codec micro-benchmark
+#
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+    codec_test.c \
+    ../common/codec.c
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../common
+LOCAL_CFLAGS += -Wall -Wextra -Wno-unused-parameter -Werror
+LOCAL_GTEST := false
+LOCAL_MODULE := impl-ril_codec_test
+LOCAL_MODULE_TAGS := tests
+include $(BUILD_HOST_NATIVE_TEST)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+    at_tok_test.c \
+    ../common/at_tok.c
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../common
+LOCAL_CFLAGS += -Wall -Wextra -Wno-unused-parameter -Werror
+LOCAL_GTEST := false
+LOCAL_MODULE := impl-ril_at_tok_test
+LOCAL_MODULE_TAGS := tests
+include $(BUILD_HOST_NATIVE_TEST)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+    codec_benchmark.c \
+    ../common/codec.c
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../common
+LOCAL_CFLAGS += -O2 -Wall -Wextra -Wno-unused-parameter -Werror
+LOCAL_MODULE := impl-ril_codec_benchmark
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
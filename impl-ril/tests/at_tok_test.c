@@ -0,0 +1,173 @@
+/**
+ * at_tok_test.c --- host test of the read-only AT cursor parser
+ *
+ * Copyright (C) 2019 UNISOC Technologies Co.,Ltd.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "at_tok.h"
+
+static int s_failures = 0;
+
+#define EXPECT(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+        s_failures++; \
+    } \
+} while (0)
+
+static void testQuotedComma(void) {
+    const char *line = "+SPNWNAME: 46000,\"China, Mobile\",\"CMCC\",3";
+    ATCursor cur;
+    int plmn = -1, act = -1;
+    char longName[32] = {0};
+    char shortName[32] = {0};
+
+    EXPECT(at_cursor_start(&cur, line) == 0);
+    EXPECT(at_cursor_scan(&cur, "int,str,str,int", &plmn,
+                          longName, sizeof(longName),
+                          shortName, sizeof(shortName), &act) == 0);
+    EXPECT(plmn == 46000);
+    EXPECT(strcmp(longName, "China, Mobile") == 0);
+    EXPECT(strcmp(shortName, "CMCC") == 0);
+    EXPECT(act == 3);
+    EXPECT(cur.field == 4);
+    EXPECT(!at_cursor_hasmore(&cur));
+
+    /* the same through the single field calls */
+    EXPECT(at_cursor_start(&cur, line) == 0);
+    EXPECT(at_cursor_nextint(&cur, &plmn) == 0);
+    EXPECT(at_cursor_nextstr(&cur, longName, sizeof(longName)) == 0);
+    EXPECT(strcmp(longName, "China, Mobile") == 0);
+    EXPECT(at_cursor_nextstr(&cur, shortName, sizeof(shortName)) == 0);
+    EXPECT(at_cursor_nextint(&cur, &act) == 0 && act == 3);
+    EXPECT(at_cursor_nextint(&cur, &act) == -1);
+}
+
+static void testOptionalFields(void) {
+    ATCursor cur;
+    int a = -1, b = 7, c = 8, d = 9;
+    char s[8] = "dflt";
+
+    /* empty optional fields keep their preset defaults */
+    EXPECT(at_cursor_start(&cur, "+CSCON: 1,,\"\",4") == 0);
+    EXPECT(at_cursor_scan(&cur, "int,int?,str?,int?", &a, &b,
+                          s, sizeof(s), &d) == 0);
+    EXPECT(a == 1 && b == 7 && d == 4);
+    EXPECT(strcmp(s, "dflt") == 0);
+
+    /* missing trailing optional fields too */
+    a = -1; b = 7; c = 8; d = 9;
+    EXPECT(at_cursor_start(&cur, "+CSCON: 1") == 0);
+    EXPECT(at_cursor_scan(&cur, "int,int?,int?,hex?", &a, &b, &c, &d) == 0);
+    EXPECT(a == 1 && b == 7 && c == 8 && d == 9);
+
+    /* a missing mandatory field fails */
+    EXPECT(at_cursor_start(&cur, "+CSCON: 1") == 0);
+    EXPECT(at_cursor_scan(&cur, "int,int", &a, &b) == -1);
+    EXPECT(cur.field == 1);
+
+    /* an empty mandatory int fails, an empty mandatory str is "" */
+    EXPECT(at_cursor_start(&cur, "+CSCON: 1,,") == 0);
+    EXPECT(at_cursor_scan(&cur, "int,int", &a, &b) == -1);
+    EXPECT(cur.field == 1);
+    EXPECT(at_cursor_start(&cur, "+CSCON: 1,\"\"") == 0);
+    EXPECT(at_cursor_scan(&cur, "int,str", &a, s, sizeof(s)) == 0);
+    EXPECT(s[0] == '\0');
+}
+
+static void testBadFieldIndex(void) {
+    ATCursor cur;
+    int a = 0, b = 0, c = 0;
+    char s[8] = {0};
+
+    EXPECT(at_cursor_start(&cur, "+CIREGU: 1,abc,3") == 0);
+    EXPECT(at_cursor_scan(&cur, "int,int,int", &a, &b, &c) == -1);
+    EXPECT(cur.field == 1);
+    EXPECT(a == 1);
+
+    EXPECT(at_cursor_start(&cur, "+CIREGU: 1,\"x\",2,zz") == 0);
+    EXPECT(at_cursor_scan(&cur, "int,skip,int,int", &a, &b, &c) == -1);
+    EXPECT(cur.field == 3);
+    EXPECT(b == 2);
+
+    /* an unknown schema type is reported at its own index */
+    EXPECT(at_cursor_start(&cur, "+CIREGU: 1,2") == 0);
+    EXPECT(at_cursor_scan(&cur, "int,float", &a, &b) == -1);
+    EXPECT(cur.field == 1);
+
+    /* a line without a prefix is rejected */
+    EXPECT(at_cursor_start(&cur, "no prefix") == -1);
+    EXPECT(at_cursor_start(&cur, NULL) == -1);
+    EXPECT(!at_cursor_hasmore(&cur));
+    EXPECT(at_cursor_nextstr(&cur, s, sizeof(s)) == -1);
+}
+
+static void testHexFields(void) {
+    ATCursor cur;
+    int lac = 0, ci = 0, act = 0;
+
+    EXPECT(at_cursor_start(&cur, "+CEREG: \"1A2b\",\"0FFFFFFF\",7") == 0);
+    EXPECT(at_cursor_scan(&cur, "hex,hex,int", &lac, &ci, &act) == 0);
+    EXPECT(lac == 0x1A2B);
+    EXPECT(ci == 0x0FFFFFFF);
+    EXPECT(act == 7);
+
+    EXPECT(at_cursor_start(&cur, "+CEREG: ff,g1") == 0);
+    EXPECT(at_cursor_nexthexint(&cur, &lac) == 0 && lac == 0xFF);
+    EXPECT(at_cursor_nexthexint(&cur, &ci) == -1);
+    EXPECT(cur.field == 1);
+
+    /* "10" is sixteen as hex and ten as int */
+    EXPECT(at_cursor_start(&cur, "+X: 10,10") == 0);
+    EXPECT(at_cursor_scan(&cur, "hex,int", &lac, &ci) == 0);
+    EXPECT(lac == 16 && ci == 10);
+}
+
+static void testStrTruncation(void) {
+    ATCursor cur;
+    char s[4] = {0};
+
+    EXPECT(at_cursor_start(&cur, "+SPCTEC: \"abcdef\",1") == 0);
+    EXPECT(at_cursor_nextstr(&cur, s, sizeof(s)) == 0);
+    EXPECT(strcmp(s, "abc") == 0);
+    EXPECT(cur.field == 1);
+}
+
+static void testLineNotModified(void) {
+    char line[] = "+SPNRCFGINFO: 1,\"a,b\",,\"ff\", 42";
+    char copy[sizeof(line)];
+    ATCursor cur;
+    int a = 0, b = 0, c = 0;
+    char s[8] = {0};
+
+    memcpy(copy, line, sizeof(line));
+    EXPECT(at_cursor_start(&cur, line) == 0);
+    EXPECT(at_cursor_scan(&cur, "int,str,int?,hex,int", &a, s, sizeof(s),
+                          &b, &c, &b) == 0);
+    EXPECT(a == 1 && c == 0xFF && b == 42);
+    EXPECT(strcmp(s, "a,b") == 0);
+    EXPECT(memcmp(line, copy, sizeof(line)) == 0);
+
+    EXPECT(at_cursor_start(&cur, line) == 0);
+    EXPECT(at_cursor_scan(&cur, "int,int", &a, &b) == -1);
+    EXPECT(memcmp(line, copy, sizeof(line)) == 0);
+}
+
+int main(void) {
+    testQuotedComma();
+    testOptionalFields();
+    testBadFieldIndex();
+    testHexFields();
+    testStrTruncation();
+    testLineNotModified();
+
+    if (s_failures > 0) {
+        fprintf(stderr, "at_tok_test: %d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("at_tok_test: all passed\n");
+    return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * codec_benchmark.c --- host micro-benchmark of the hex and UCS2 conversion
+ * functions, on inputs sized like SIM_IO responses and USSD strings
+ *
+ * Copyright (C) 2019 UNISOC Technologies Co.,Ltd.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "codec.h"
+
+#define DEFAULT_ITERATIONS  200000
+#define RECORD_LEN          256     /* bytes of a SIM_IO record */
+#define USSD_LEN            182     /* UCS2 chars of a long USSD string */
+
+static long long getNsec(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void report(const char *name, int iterations, int bytes,
+                   long long elapsedNsec) {
+    printf("%-12s %8d iterations, %4d bytes: %8.1f ns/op, %8.1f MB/s\n",
+           name, iterations, bytes, (double)elapsedNsec / iterations,
+           (double)bytes * iterations * 1000.0 / elapsedNsec);
+}
+
+int main(int argc, char **argv) {
+    int iterations = DEFAULT_ITERATIONS;
+    int i, n;
+    long long start;
+    unsigned int sink = 0;
+    uint8_t bin[RECORD_LEN];
+    char hex[2 * RECORD_LEN + 1];
+    uint8_t ucs2[2 * USSD_LEN];
+    char utf8[4 * USSD_LEN + 1];
+
+    if (argc > 1) {
+        iterations = atoi(argv[1]);
+        if (iterations <= 0) {
+            fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < RECORD_LEN; i++) {
+        bin[i] = (uint8_t)(i * 7 + 3);
+    }
+    /* mix ASCII with CJK so both paths of ucs2ToUtf8 run */
+    for (i = 0; i < USSD_LEN; i++) {
+        ucs2[2 * i] = (i % 3 == 0) ? 0x4E : 0x00;
+        ucs2[2 * i + 1] = (uint8_t)(0x30 + i % 64);
+    }
+
+    start = getNsec();
+    for (i = 0; i < iterations; i++) {
+        bin[0] = (uint8_t)i;
+        sink += (unsigned int)(binToHex(bin, RECORD_LEN, hex) - hex);
+    }
+    report("binToHex", iterations, RECORD_LEN, getNsec() - start);
+
+    start = getNsec();
+    for (i = 0; i < iterations; i++) {
+        n = hexToBin(hex, 2 * RECORD_LEN, bin);
+        sink += (unsigned int)n + bin[i % RECORD_LEN];
+    }
+    report("hexToBin", iterations, 2 * RECORD_LEN, getNsec() - start);
+
+    start = getNsec();
+    for (i = 0; i < iterations; i++) {
+        ucs2[1] = (uint8_t)(0x30 + i % 64);
+        sink += (unsigned int)ucs2ToUtf8(ucs2, sizeof(ucs2), utf8,
+                                         sizeof(utf8));
+    }
+    report("ucs2ToUtf8", iterations, (int)sizeof(ucs2), getNsec() - start);
+
+    /* keeps the compiler from dropping the loops */
+    return sink == 0 ? 2 : 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * codec_test.c --- host test of the hex and UCS2 conversion functions
+ *
+ * Copyright (C) 2019 UNISOC Technologies Co.,Ltd.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "codec.h"
+
+static int s_failures = 0;
+
+#define EXPECT(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+        s_failures++; \
+    } \
+} while (0)
+
+static void testHexRoundTrip(void) {
+    const uint8_t bin[] = {0x00, 0x01, 0x7F, 0x80, 0xAB, 0xCD, 0xEF, 0xFF};
+    uint8_t out[sizeof(bin)] = {0};
+    char hex[2 * sizeof(bin) + 1] = {0};
+    char *end = NULL;
+
+    end = binToHex(bin, sizeof(bin), hex);
+    EXPECT(strcmp(hex, "00017F80ABCDEFFF") == 0);
+    EXPECT(end == hex + 2 * sizeof(bin) && *end == '\0');
+
+    EXPECT(hexToBin(hex, strlen(hex), out) == (int)sizeof(bin));
+    EXPECT(memcmp(out, bin, sizeof(bin)) == 0);
+
+    memset(out, 0, sizeof(out));
+    EXPECT(hexToBin("00017f80abcdefff", 16, out) == (int)sizeof(bin));
+    EXPECT(memcmp(out, bin, sizeof(bin)) == 0);
+
+    memset(out, 0, sizeof(out));
+    EXPECT(hexToBin("aBcD", 4, out) == 2);
+    EXPECT(out[0] == 0xAB && out[1] == 0xCD);
+
+    EXPECT(hexToBin("", 0, out) == 0);
+    end = binToHex(bin, 0, hex);
+    EXPECT(end == hex && hex[0] == '\0');
+}
+
+static void testHexInvalid(void) {
+    uint8_t out[4] = {0};
+
+    EXPECT(hexToBin("ABC", 3, out) == -1);
+    EXPECT(hexToBin("A", 1, out) == -1);
+    EXPECT(hexToBin("0G", 2, out) == -1);
+    EXPECT(hexToBin("G0", 2, out) == -1);
+    EXPECT(hexToBin("12 4", 4, out) == -1);
+    EXPECT(hexToBin("12\0004", 4, out) == -1);
+    EXPECT(hexToBin("\xC1\xC2", 2, out) == -1);
+    EXPECT(hexToBin("12", -2, out) == -1);
+    EXPECT(hexToBin(NULL, 2, out) == -1);
+    EXPECT(hexToBin("12", 2, NULL) == -1);
+}
+
+static void testUcs2Basic(void) {
+    /* "A", U+00E9, U+4E2D, U+20AC */
+    const uint8_t ucs2[] = {0x00, 0x41, 0x00, 0xE9, 0x4E, 0x2D, 0x20, 0xAC};
+    char utf8[32];
+
+    EXPECT(ucs2ToUtf8(ucs2, sizeof(ucs2), utf8, sizeof(utf8)) == 9);
+    EXPECT(strcmp(utf8, "A\xC3\xA9\xE4\xB8\xAD\xE2\x82\xAC") == 0);
+
+    /* a trailing odd byte is ignored */
+    EXPECT(ucs2ToUtf8(ucs2, 3, utf8, sizeof(utf8)) == 1);
+    EXPECT(strcmp(utf8, "A") == 0);
+
+    EXPECT(ucs2ToUtf8(ucs2, 0, utf8, sizeof(utf8)) == 0);
+    EXPECT(utf8[0] == '\0');
+}
+
+static void testUcs2Surrogates(void) {
+    /* U+1F600 as D83D DE00 */
+    const uint8_t pair[] = {0xD8, 0x3D, 0xDE, 0x00};
+    /* lone high surrogate followed by "B" */
+    const uint8_t loneHigh[] = {0xD8, 0x3D, 0x00, 0x42};
+    /* lone low surrogate */
+    const uint8_t loneLow[] = {0xDE, 0x00};
+    /* high surrogate at the end of input */
+    const uint8_t truncatedPair[] = {0x00, 0x41, 0xD8, 0x3D};
+    char utf8[32];
+
+    EXPECT(ucs2ToUtf8(pair, sizeof(pair), utf8, sizeof(utf8)) == 4);
+    EXPECT(strcmp(utf8, "\xF0\x9F\x98\x80") == 0);
+
+    EXPECT(ucs2ToUtf8(loneHigh, sizeof(loneHigh), utf8, sizeof(utf8)) == 4);
+    EXPECT(strcmp(utf8, "\xEF\xBF\xBD" "B") == 0);
+
+    EXPECT(ucs2ToUtf8(loneLow, sizeof(loneLow), utf8, sizeof(utf8)) == 3);
+    EXPECT(strcmp(utf8, "\xEF\xBF\xBD") == 0);
+
+    EXPECT(ucs2ToUtf8(truncatedPair, sizeof(truncatedPair), utf8,
+                      sizeof(utf8)) == 4);
+    EXPECT(strcmp(utf8, "A\xEF\xBF\xBD") == 0);
+}
+
+static void testUcs2Truncation(void) {
+    /* "A", U+4E2D, U+1F600 */
+    const uint8_t ucs2[] = {0x00, 0x41, 0x4E, 0x2D, 0xD8, 0x3D, 0xDE, 0x00};
+    char utf8[16];
+
+    /* each size cuts at the last character that fits with its '\0' */
+    EXPECT(ucs2ToUtf8(ucs2, sizeof(ucs2), utf8, 1) == 0);
+    EXPECT(utf8[0] == '\0');
+    EXPECT(ucs2ToUtf8(ucs2, sizeof(ucs2), utf8, 2) == 1);
+    EXPECT(strcmp(utf8, "A") == 0);
+    EXPECT(ucs2ToUtf8(ucs2, sizeof(ucs2), utf8, 4) == 1);
+    EXPECT(strcmp(utf8, "A") == 0);
+    EXPECT(ucs2ToUtf8(ucs2, sizeof(ucs2), utf8, 5) == 4);
+    EXPECT(strcmp(utf8, "A\xE4\xB8\xAD") == 0);
+    EXPECT(ucs2ToUtf8(ucs2, sizeof(ucs2), utf8, 8) == 4);
+    EXPECT(ucs2ToUtf8(ucs2, sizeof(ucs2), utf8, 9) == 8);
+    EXPECT(strcmp(utf8, "A\xE4\xB8\xAD\xF0\x9F\x98\x80") == 0);
+
+    /* nothing is written without room for the '\0' */
+    utf8[0] = 'x';
+    EXPECT(ucs2ToUtf8(ucs2, sizeof(ucs2), utf8, 0) == 0);
+    EXPECT(utf8[0] == 'x');
+    EXPECT(ucs2ToUtf8(ucs2, sizeof(ucs2), NULL, 8) == 0);
+}
+
+int main(void) {
+    testHexRoundTrip();
+    testHexInvalid();
+    testUcs2Basic();
+    testUcs2Surrogates();
+    testUcs2Truncation();
+
+    if (s_failures > 0) {
+        fprintf(stderr, "codec_test: %d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("codec_test: all passed\n");
+    return 0;
+}
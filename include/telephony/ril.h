@@ -3830,6 +3830,7 @@ typedef struct {
     size_t len;
 } SE_OpenChannelParams;
 
+/* APDU bytes. Response data of SE_transmit is malloc'ed, caller frees it */
 typedef struct {
   uint8_t *data;
   size_t len;
@@ -22,6 +22,9 @@
 
 #include "lite_ril.h"
 #include "../impl-ril/common/at_tok.h"
+extern "C" {
+#include "../impl-ril/common/misc.h"
+}
 
 using ::android::hardware::Return;
 using ::android::hardware::hidl_string;
@@ -128,7 +131,7 @@ Return<void> LiteRadioImpl::sendCmd(int32_t serial,
     char *atCmd = NULL;
     if (!copyHidlStringToRil(&atCmd, cmd.c_str())) {
         const char *response = "ERROR";
-        sendCmdResponse(serial, mServiceId, response, sizeof("ERROR"));
+        sendCmdResponse(serial, mServiceId, response, strlen(response));
         return Void();
     }
 
@@ -189,8 +192,11 @@ static int sendCmdResponse(int serial, int serviceId, const void *data,
 
         RLOGD("sendCmdResponse: dataSize = %zu", dataSize);
 
+        /* data outlives the call, no need to copy it into the hidl_string */
+        hidl_string response;
+        response.setToExternal((const char *)data, dataSize);
         Return<void> retStatus = radioService[serviceId]->mLiteRadioResponse->
-                sendCmdResponse(responseInfo, convertCharPtrToHidlString((char *)data));
+                sendCmdResponse(responseInfo, response);
     } else {
         RLOGE("radioService[%d]->mLiteRadioResponse == NULL", serviceId);
     }
@@ -229,42 +235,6 @@ static int getMacAddrInfo(char *ptr) {
     return 1;
 }
 
-static int strStartsWith(const char *line, const char *prefix) {
-    for ( ; *line != '\0' && *prefix != '\0' ; line++, prefix++) {
-        if (*line != *prefix) return 0;
-    }
-    return *prefix == '\0';
-}
-
-static void addIntermediate(ChannelInfo *chInfo) {
-    RespLine *p_new = (RespLine *)malloc(sizeof(RespLine));
-    p_new->line = strdup(chInfo->line);
-    p_new->p_next = chInfo->sp_response->p_intermediates;
-    chInfo->sp_response->p_intermediates = p_new;
-}
-
-static const char *s_finalResponsesError[] = {"ERROR", "+CMS ERROR:", "+CME ERROR:"};
-static int isFinalResponseError(const char *line) {
-    size_t i;
-    for (i = 0; i < NUM_ELEMS(s_finalResponsesError); i++) {
-        if (strStartsWith(line, s_finalResponsesError[i])) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-static const char *s_finalResponsesSuccess[] = {"OK", "CONNECT"};
-static int isFinalResponseSuccess(const char *line) {
-    size_t i;
-    for (i = 0; i < NUM_ELEMS(s_finalResponsesSuccess); i++) {
-        if (strStartsWith(line, s_finalResponsesSuccess[i])) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
 static void handleFinalResponse(int serviceId, ChannelInfo *chInfo) {
     chInfo->sp_response->finalResponse = strdup(chInfo->line);
     pthread_cond_signal(&s_channelCond[serviceId]);
@@ -323,78 +293,17 @@ static void processLine(int serviceId, ChannelInfo *chInfo) {
         chInfo->sp_response->success = 0;
         handleFinalResponse(serviceId, chInfo);
     } else {
-        addIntermediate(chInfo);
+        at_response_add_line(chInfo->sp_response, chInfo->line);
     }
     pthread_mutex_unlock(&s_channelMutex[serviceId]);
 }
 
-static char *findNextEOL(char *cur) {
-    if (cur[0] == '>' && cur[1] == ' ' && cur[2] == '\0') {
-        return cur+2;  /* SMS prompt character...not \r terminated */
-    }
-    while (*cur != '\0' && *cur != '\r' && *cur != '\n') cur++;
-
-    return *cur == '\0' ? NULL : cur;
-}
-
 static const char *readline(ChannelInfo *chInfo) {
-    ssize_t count, err_count = 0;
-    char *p_read = NULL, *p_eol = NULL;
-
-    if (*chInfo->s_respBufferCur == '\0') {  // empty buffer
-        chInfo->s_respBufferCur = chInfo->s_respBuffer;
-        *chInfo->s_respBufferCur = '\0';
-        p_read = chInfo->s_respBuffer;
-    } else {  // there's data in the buffer from the last read
-        while (*chInfo->s_respBufferCur == '\r' || *chInfo->s_respBufferCur == '\n') {
-            chInfo->s_respBufferCur++;
-        }
-
-        p_eol = findNextEOL(chInfo->s_respBufferCur);
-        if (p_eol == NULL) {
-            size_t len = strlen(chInfo->s_respBufferCur);
-            memmove(chInfo->s_respBuffer, chInfo->s_respBufferCur, len + 1);
-            p_read = chInfo->s_respBuffer + len;
-            chInfo->s_respBufferCur = chInfo->s_respBuffer;
-        }
-    }
-
-    while (p_eol == NULL) {
-        if (0 == MAX_BUFFER_BYTES - (p_read - chInfo->s_respBuffer)) {
-            chInfo->s_respBufferCur = chInfo->s_respBuffer;
-            *chInfo->s_respBufferCur = '\0';
-            p_read = chInfo->s_respBuffer;
-        }
-
-        do {
-            count = read(chInfo->s_fd, p_read, MAX_BUFFER_BYTES - (p_read - chInfo->s_respBuffer));
-        } while (count < 0 && errno == EINTR);
-
-        if (count > 0) {
-            p_read[count] = '\0';
-            while (*chInfo->s_respBufferCur == '\r' || *chInfo->s_respBufferCur == '\n') {
-                chInfo->s_respBufferCur++;
-            }
-            p_eol = findNextEOL(chInfo->s_respBufferCur);
-            p_read += count;
-            err_count = 0;
-        } else if (count <= 0) {  /* read error encountered or EOF reached */
-            if (count == 0) {
-                err_count++;
-                if (err_count > 10) {
-                    sleep(10);
-                } else {
-                    RLOGE("atchannel: EOF reached. err_count = %zd", err_count);
-                }
-            }
-            return NULL;
-        }
+    chInfo->line = at_reader_readline(&chInfo->reader);
+    if (chInfo->line == NULL) {
+        return NULL;
     }
 
-    chInfo->line = chInfo->s_respBufferCur;
-    *p_eol = '\0';
-    chInfo->s_respBufferCur = p_eol + 1;
-
     RLOGD("%s: Recv < %s\n", chInfo->name, chInfo->line);
 
     return chInfo->line;
@@ -427,40 +336,8 @@ static int writeline(ChannelInfo *chInfo, const char *s) {
     return 0;
 }
 
-static CmdResponse * at_response_new() {
-    return (CmdResponse *)calloc(1, sizeof(CmdResponse));
-}
-
-static void at_response_free(CmdResponse *p_response) {
-    if (p_response == NULL) return;
-
-    RespLine *p_line = p_response->p_intermediates;
-    while (p_line != NULL) {
-        RespLine *p_toFree = p_line;
-        p_line = p_line->p_next;
-        free(p_toFree->line);
-        free(p_toFree);
-    }
-
-    free(p_response->finalResponse);
-    free(p_response);
-}
-
-static void reverseIntermediates(ChannelInfo *chInfo) {
-    RespLine *pcur, *pnext;
-    pcur = chInfo->sp_response->p_intermediates;
-    chInfo->sp_response->p_intermediates = NULL;
-
-    while (pcur != NULL) {
-        pnext = pcur->p_next;
-        pcur->p_next = chInfo->sp_response->p_intermediates;
-        chInfo->sp_response->p_intermediates = pcur;
-        pcur = pnext;
-    }
-}
-
 static void clearPendingCommand(struct ChannelInfo *chInfo) {
-    CmdResponse *sp_response = chInfo->sp_response;
+    ATResponse *sp_response = chInfo->sp_response;
 
     if (sp_response != NULL) {
         at_response_free(sp_response);
@@ -472,7 +349,7 @@ static void clearPendingCommand(struct ChannelInfo *chInfo) {
 
 static int send_command_full_nolock(int serviceId, const char *command,
                                     const char *responsePrefix, int timeoutSec,
-                                    CmdResponse **pp_outResponse) {
+                                    ATResponse **pp_outResponse) {
     int err = 0;
     struct timespec ts;
     struct timespec tv;
@@ -514,7 +391,7 @@ static int send_command_full_nolock(int serviceId, const char *command,
     if (pp_outResponse == NULL) {
         at_response_free(chInfo->sp_response);
     } else {  /* line reader stores intermediate responses in reverse order */
-        reverseIntermediates(chInfo);
+        at_response_reverse(chInfo->sp_response);
         *pp_outResponse = chInfo->sp_response;
     }
 
@@ -526,14 +403,43 @@ done:
     return err;
 }
 
+/**
+ * Appends n chars of s, growing the buffer geometrically. writer->data is
+ * kept '\0' terminated so it can be handed to HIDL as an external string.
+ */
+static bool writerAppend(ResponseWriter *writer, const char *s, size_t n) {
+    if (writer->len + n + 1 > writer->size) {
+        size_t size = writer->size == 0 ? ARRAY_SIZE * 8 : writer->size;
+        while (size < writer->len + n + 1) {
+            size *= 2;
+        }
+        char *data = (char *)realloc(writer->data, size);
+        if (data == NULL) {
+            RLOGE("writerAppend: failed to grow to %zu bytes", size);
+            return false;
+        }
+        writer->data = data;
+        writer->size = size;
+    }
+    memcpy(writer->data + writer->len, s, n);
+    writer->len += n;
+    writer->data[writer->len] = '\0';
+    return true;
+}
+
+static bool writerAppendLine(ResponseWriter *writer, const char *line) {
+    return writerAppend(writer, line, strlen(line)) &&
+           writerAppend(writer, "\r\n", 2);
+}
+
 static int sendCommand(int serial, int serviceId, const char *command, int tag) {
     int timeoutSec = 60;
-    int err, i;
+    int err;
+    bool ok = true;
     const char *responsePrefix = NULL;
-    char buf[ARRAY_SIZE * 8] = {0};
-    char *response = NULL;
-    RespLine *p_cur = NULL;
-    CmdResponse *p_outResponse = NULL;
+    ResponseWriter writer = {NULL, 0, 0};
+    ATLine *p_cur = NULL;
+    ATResponse *p_outResponse = NULL;
 
     pthread_mutex_lock(&s_channelMutex[serviceId]);
     err = send_command_full_nolock(serviceId, command, responsePrefix, timeoutSec,
@@ -545,36 +451,39 @@ static int sendCommand(int serial, int serviceId, const char *command, int tag)
             int status = 0;
             char *line = NULL;
             char cmdBuf[ARRAY_SIZE * 8] = {0};
+            char echoBuf[ARRAY_SIZE] = {0};
             snprintf(cmdBuf, sizeof(cmdBuf), "%s", command);
             line = cmdBuf;
             at_tok_start_flag(&line, '=');
             at_tok_nextint(&line, &status);
-            snprintf(buf, sizeof(buf), "AT+CEREG=%d", status);
-            strlcat(buf, "\r\n", sizeof(buf));
-        }else {
-            strlcat(buf, command, sizeof(buf));
-            strlcat(buf, "\r\n", sizeof(buf));
+            snprintf(echoBuf, sizeof(echoBuf), "AT+CEREG=%d", status);
+            ok = writerAppendLine(&writer, echoBuf);
+        } else {
+            ok = writerAppendLine(&writer, command);
         }
     }
 
     if (err < 0) {
-        strlcat(buf, "ERROR", sizeof(buf));
+        ok = ok && writerAppendLine(&writer, "ERROR");
     } else if (p_outResponse != NULL) {
-        if (p_outResponse->success == 0) {
-            strlcat(buf, p_outResponse->finalResponse, sizeof(buf));
-        } else {
+        if (p_outResponse->success != 0) {
             p_cur = p_outResponse->p_intermediates;
-            for (i = 0; p_cur != NULL; p_cur = p_cur->p_next, i++) {
-                strlcat(buf, p_cur->line, sizeof(buf));
-                strlcat(buf, "\r\n", sizeof(buf));
+            for (; ok && p_cur != NULL; p_cur = p_cur->p_next) {
+                ok = writerAppendLine(&writer, p_cur->line);
             }
-            strlcat(buf, p_outResponse->finalResponse, sizeof(buf));
         }
+        ok = ok && writerAppendLine(&writer, p_outResponse->finalResponse);
+    } else {
+        ok = ok && writerAppend(&writer, "\r\n", 2);
+    }
+
+    if (ok) {
+        sendCmdResponse(serial, serviceId, writer.data, writer.len);
+    } else {
+        sendCmdResponse(serial, serviceId, "ERROR\r\n", strlen("ERROR\r\n"));
     }
-    strlcat(buf, "\r\n", sizeof(buf));
-    response = buf;
-    sendCmdResponse(serial, serviceId, response, strlen(response));
 
+    free(writer.data);
     at_response_free(p_outResponse);
     return err;
 }
@@ -783,8 +692,8 @@ retry:
         }
 
         s_channelInfo[serviceId][index].s_fd = fd;
-        memset(s_channelInfo[serviceId][index].s_respBuffer, 0, MAX_BUFFER_BYTES + 1);
-        s_channelInfo[serviceId][index].s_respBufferCur = s_channelInfo[serviceId][index].s_respBuffer;
+        at_reader_init(&s_channelInfo[serviceId][index].reader, fd,
+                       s_channelInfo[serviceId][index].s_respBuffer, MAX_BUFFER_BYTES);
         snprintf(s_channelInfo[serviceId][index].name, MAX_NAME_LENGTH, "CMUX%d", index + serviceMuxIndex);
         FD_SET(fd, &s_readFds[serviceId]);
         if (fd >= s_nfds[serviceId]) s_nfds[serviceId] = fd + 1;
@@ -8,6 +8,8 @@
 #ifndef LITE_RIL_H_
 #define LITE_RIL_H_
 
+#include "../impl-ril/common/at_engine.h"
+
 #define MAX_NAME_LENGTH                 32
 #define MAX_BUFFER_BYTES                (8 * 1024)
 #define MUX_NUM                         2
@@ -55,28 +57,21 @@ typedef enum {
     MAX_SERVICE_NUM
 } SERVICE_ID;
 
-typedef struct RespLine { /* a singly-lined list of intermediate responses */
-    struct RespLine *p_next;
-    char *line;
-} RespLine;
-
-typedef struct {
-    int success;                /* true if final response indicates success (eg "OK") */
-    char *finalResponse;        /* eg OK, ERROR */
-    RespLine *p_intermediates;    /* any intermediate responses */
-} CmdResponse;
-
 typedef struct ChannelInfo {
     int s_fd;
     int channelID;
     char name[128];
     char s_respBuffer[MAX_BUFFER_BYTES + 1];
-    char *s_respBufferCur;
+    ATLineReader reader;
     char *line; /* current line */
     char *s_responsePrefix;
-    CmdResponse *sp_response;
-    char *p_read;
-    char *p_eol;
+    ATResponse *sp_response;
 } ChannelInfo;
 
+typedef struct ResponseWriter { /* see writerAppend() */
+    char *data;
+    size_t len;
+    size_t size;
+} ResponseWriter;
+
 #endif  // LITE_RIL_H_
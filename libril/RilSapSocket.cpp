@@ -212,16 +212,17 @@ void RilSapSocket::dispatchRequest(MsgHeader *req) {
     currRequest->p_next = NULL;
     currRequest->socketId = id;
 
-    pendingResponseQueue.enqueue(currRequest);
+    pendingResponses.add(currRequest);
 
     if (uimFuncs) {
         RLOGI("RilSapSocket::dispatchRequest [%d] > SAP REQUEST type: %d. id: %d. error: %d, \
-                token 0x%p",
+                token 0x%p, pending %zu",
                 req->token,
                 req->type,
                 req->id,
                 req->error,
-                currRequest );
+                currRequest,
+                pendingResponses.size());
 
 #if defined(ANDROID_MULTI_SIM)
         uimFuncs->onRequest(req->id, req->payload->bytes, req->payload->size, currRequest, id);
@@ -266,7 +267,7 @@ void RilSapSocket::onRequestComplete(RIL_Token t, RIL_Errno e, void *response,
     }
 
     // Deallocate SapSocketRequest
-    if(!pendingResponseQueue.checkAndDequeue(hdr->id, hdr->token)) {
+    if(!pendingResponses.checkAndRemove(hdr->id, hdr->token)) {
         RLOGE("Token:%d, MessageId:%d", hdr->token, hdr->id);
         RLOGE ("RilSapSocket::onRequestComplete: invalid Token or Message Id");
     }
@@ -52,14 +52,9 @@ class RilSapSocket : public RilSocket {
     } SapSocketRequest;
 
     /**
-     * Queue for requests that are pending dispatch.
+     * Requests that are dispatched but are pending response
      */
-    Ril_queue<SapSocketRequest> dispatchQueue;
-
-    /**
-     * Queue for requests that are dispatched but are pending response
-     */
-    Ril_queue<SapSocketRequest> pendingResponseQueue;
+    Ril_pendingTable<SapSocketRequest> pendingResponses;
 
     public:
         /**
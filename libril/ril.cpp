@@ -238,8 +238,12 @@ char * SE_getServiceName() {
     return secureElement_service_name;
 }
 
+/**
+ * payloadLen zeroed bytes for the request data are allocated behind the
+ * RequestInfo, see REQUEST_INFO_PAYLOAD(), and freed together with it.
+ */
 RequestInfo *
-addRequestToList(int serial, int slotId, int request) {
+addRequestToListWithPayload(int serial, int slotId, int request, size_t payloadLen) {
     RequestInfo *pRI;
     int ret = 0;
     RIL_SOCKET_ID socket_id = (RIL_SOCKET_ID) slotId;
@@ -268,7 +272,7 @@ addRequestToList(int serial, int slotId, int request) {
 #endif
 #endif
 
-    pRI = (RequestInfo *)calloc(1, sizeof(RequestInfo));
+    pRI = (RequestInfo *)calloc(1, sizeof(RequestInfo) + payloadLen);
     if (pRI == NULL) {
         RLOGE("Memory allocation failed for request %s", requestToString(request));
         return NULL;
@@ -302,6 +306,11 @@ addRequestToList(int serial, int slotId, int request) {
     return pRI;
 }
 
+RequestInfo *
+addRequestToList(int serial, int slotId, int request) {
+    return addRequestToListWithPayload(serial, slotId, request, 0);
+}
+
 static void resendLastNITZTimeData(RIL_SOCKET_ID socket_id) {
     if (s_lastNITZTimeData != NULL) {
         int responseType = (s_callbacks.version >= 13)
@@ -16,6 +16,8 @@
 
 #include "pb_decode.h"
 #include <pthread.h>
+#include <atomic>
+#include <unordered_map>
 #include <hardware/ril/librilutils/proto/sap-api.pb.h>
 #include <utils/Log.h>
 
@@ -165,3 +167,100 @@ int Ril_queue<T>::empty(void) {
         return 0;
     }
 }
+
+/**
+ * Template table of dispatched requests waiting for their response.
+ * <p>
+ * Requests are indexed by token, so matching a response does not walk
+ * every outstanding request the way Ril_queue::checkAndDequeue() does.
+ * T needs the same token and curr->id members as for Ril_queue.
+ */
+
+template <typename T>
+class Ril_pendingTable {
+
+   /**
+     * Table mutex variable for synchronized access.
+     */
+    pthread_mutex_t mutex_instance;
+
+   /**
+     * Pending requests by token, tokens are not required to be unique.
+     */
+    unordered_multimap<int, T*> requests;
+
+   /**
+     * Number of pending requests, readable without taking the mutex.
+     */
+    atomic<size_t> depth;
+
+    public:
+
+       /**
+         * Add a dispatched request.
+         *
+         * @param Request to be added.
+         */
+        void add(T* request);
+
+       /**
+         * Check and remove an element with a particular message id and token.
+         * The element is freed.
+         *
+         * @param Request message id.
+         * @param Request token.
+         */
+        int checkAndRemove(MsgId id, int token);
+
+       /**
+         * Number of requests still waiting for a response.
+         */
+        size_t size(void) const;
+
+       /**
+         * Table constructor.
+         */
+        Ril_pendingTable(void);
+};
+
+template <typename T>
+Ril_pendingTable<T>::Ril_pendingTable(void) : depth(0) {
+    pthread_mutex_init(&mutex_instance, NULL);
+}
+
+template <typename T>
+void Ril_pendingTable<T>::add(T* request) {
+    pthread_mutex_lock(&mutex_instance);
+    requests.emplace(request->token, request);
+    depth.store(requests.size(), memory_order_relaxed);
+    pthread_mutex_unlock(&mutex_instance);
+}
+
+template <typename T>
+int Ril_pendingTable<T>::checkAndRemove(MsgId id, int token) {
+    int ret = 0;
+    T* temp = NULL;
+
+    pthread_mutex_lock(&mutex_instance);
+
+    auto range = requests.equal_range(token);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (id == it->second->curr->id) {
+            ret = 1;
+            temp = it->second;
+            requests.erase(it);
+            break;
+        }
+    }
+    depth.store(requests.size(), memory_order_relaxed);
+
+    pthread_mutex_unlock(&mutex_instance);
+
+    free(temp);
+    return ret;
+}
+
+template <typename T>
+size_t Ril_pendingTable<T>::size(void) const {
+    return depth.load(memory_order_relaxed);
+}
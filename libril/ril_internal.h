@@ -106,6 +106,12 @@ typedef struct CommandInfo {
 
 RequestInfo * addRequestToList(int serial, int slotId, int request);
 
+/* sizeof(RequestInfo) is a multiple of pointer alignment, so is the payload */
+#define REQUEST_INFO_PAYLOAD(pRI)   ((void *)((pRI) + 1))
+
+RequestInfo * addRequestToListWithPayload(int serial, int slotId, int request,
+        size_t payloadLen);
+
 char * RIL_getServiceName();
 
 char * SE_getServiceName();
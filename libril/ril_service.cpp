@@ -906,27 +906,61 @@ bool dispatchVoid(int serial, int slotId, int request) {
     return true;
 }
 
+/**
+ * The dispatchers below pack the request data behind the RequestInfo, see
+ * addRequestToListWithPayload(), so a request costs a single allocation.
+ * Strings are stored after their pointer array. An empty string becomes
+ * NULL unless allowEmpty, as with copyHidlStringToRil().
+ */
+static size_t packedStringSize(size_t len, bool allowEmpty) {
+    return (len == 0 && !allowEmpty) ? 0 : len + 1;
+}
+
+static char *packString(char **cursor, const char *str, size_t len, bool allowEmpty) {
+    char *dest = *cursor;
+
+    if (len == 0 && !allowEmpty) {
+        return NULL;
+    }
+    memcpy(dest, str, len);
+    dest[len] = '\0';
+    *cursor += len + 1;
+    return dest;
+}
+
+/* packed data is freed with its RequestInfo, it only has to be zeroed */
+static void memsetPackedData(void *data, size_t dataLen) {
+    memset(data, 0, dataLen);
+}
+
+static void memsetPackedStrings(void *data, size_t dataLen) {
+    char **pStrings = (char **)data;
+
+    for (size_t i = 0; i < dataLen / sizeof(char *); i++) {
+        if (pStrings[i] != NULL) {
+            memset(pStrings[i], 0, strlen(pStrings[i]));
+        }
+    }
+    memset(data, 0, dataLen);
+}
+
 bool dispatchString(int serial, int slotId, int request, const char * str) {
-    RequestInfo *pRI = android::addRequestToList(serial, slotId, request);
+    size_t len = (str == NULL) ? 0 : strlen(str);
+    RequestInfo *pRI = android::addRequestToListWithPayload(serial, slotId, request,
+            packedStringSize(len, false));
     if (pRI == NULL) {
         return false;
     }
 
-    char *pString = NULL;
-    if (!copyHidlStringToRil(&pString, str, pRI)) {
-        return false;
-    }
+    char *cursor = (char *)REQUEST_INFO_PAYLOAD(pRI);
+    char *pString = packString(&cursor, str, len, false);
 
     size_t dataLen = 0;
     if (pString != NULL) {
-        dataLen = strlen(pString) + 1;
+        dataLen = len + 1;
     }
 
-    // free memory when RIL_onRequestComplete
-    auto cb = [](void *data, size_t dataLen __attribute__((unused))) {
-        memsetAndFreeStrings(1, data);
-    };
-    REQUEST_INFO_PACK(pRI, cb, pString, dataLen);
+    REQUEST_INFO_PACK(pRI, memsetPackedData, pString, dataLen);
 
     CALL_ONREQUEST(request, pString, dataLen, pRI, pRI->socket_id);
 
@@ -935,48 +969,33 @@ bool dispatchString(int serial, int slotId, int request, const char * str) {
 
 bool dispatchStrings(int serial, int slotId, int request, bool allowEmpty,
         int countStrings, ...) {
-    RequestInfo *pRI = android::addRequestToList(serial, slotId, request);
-    if (pRI == NULL) {
-        return false;
-    }
+    size_t payloadLen = countStrings * sizeof(char *);
+    va_list ap, aq;
 
-    char **pStrings;
-    pStrings = (char **)calloc(countStrings, sizeof(char *));
-    if (pStrings == NULL) {
-        RLOGE("Memory allocation failed for request %s", requestToString(request));
-        sendErrorResponse(pRI, RIL_E_NO_MEMORY);
-        return false;
-    }
-    va_list ap;
     va_start(ap, countStrings);
+    va_copy(aq, ap);
     for (int i = 0; i < countStrings; i++) {
-        const char* str = va_arg(ap, const char *);
-        if (!copyHidlStringToRil(&pStrings[i], hidl_string(str), pRI,
-                allowEmpty)) {
-            va_end(ap);
-            for (int j = 0; j < i; j++) {
-                memsetAndFreeStrings(1, pStrings[j]);
-            }
-            free(pStrings);
-            return false;
-        }
+        const char *str = va_arg(ap, const char *);
+        payloadLen += packedStringSize(str == NULL ? 0 : strlen(str), allowEmpty);
     }
     va_end(ap);
 
-    // free memory when RIL_onRequestComplete
-    auto cb = [](void *data, size_t dataLen) {
-        int countStrings = dataLen / sizeof(char *);
-        char **pStrings = (char **)data;
+    RequestInfo *pRI = android::addRequestToListWithPayload(serial, slotId, request,
+            payloadLen);
+    if (pRI == NULL) {
+        va_end(aq);
+        return false;
+    }
 
-        if (pStrings != NULL) {
-            for (int i = 0; i < countStrings; i++) {
-                memsetAndFreeStrings(1, pStrings[i]);
-            }
-            memset(pStrings, 0, dataLen);
-            free(pStrings);
-        }
-    };
-    REQUEST_INFO_PACK(pRI, cb, pStrings, countStrings * sizeof(char *));
+    char **pStrings = (char **)REQUEST_INFO_PAYLOAD(pRI);
+    char *cursor = (char *)(pStrings + countStrings);
+    for (int i = 0; i < countStrings; i++) {
+        const char *str = va_arg(aq, const char *);
+        pStrings[i] = packString(&cursor, str, str == NULL ? 0 : strlen(str), allowEmpty);
+    }
+    va_end(aq);
+
+    REQUEST_INFO_PACK(pRI, memsetPackedStrings, pStrings, countStrings * sizeof(char *));
 
     CALL_ONREQUEST(request, pStrings, countStrings * sizeof(char *), pRI, pRI->socket_id);
 
@@ -984,44 +1003,26 @@ bool dispatchStrings(int serial, int slotId, int request, bool allowEmpty,
 }
 
 bool dispatchStrings(int serial, int slotId, int request, const hidl_vec<hidl_string>& data) {
-    RequestInfo *pRI = android::addRequestToList(serial, slotId, request);
-    if (pRI == NULL) {
-        return false;
+    int countStrings = data.size();
+    size_t payloadLen = countStrings * sizeof(char *);
+
+    for (int i = 0; i < countStrings; i++) {
+        payloadLen += packedStringSize(data[i].size(), false);
     }
 
-    int countStrings = data.size();
-    char **pStrings;
-    pStrings = (char **)calloc(countStrings, sizeof(char *));
-    if (pStrings == NULL) {
-        RLOGE("Memory allocation failed for request %s", requestToString(request));
-        sendErrorResponse(pRI, RIL_E_NO_MEMORY);
+    RequestInfo *pRI = android::addRequestToListWithPayload(serial, slotId, request,
+            payloadLen);
+    if (pRI == NULL) {
         return false;
     }
 
+    char **pStrings = (char **)REQUEST_INFO_PAYLOAD(pRI);
+    char *cursor = (char *)(pStrings + countStrings);
     for (int i = 0; i < countStrings; i++) {
-        if (!copyHidlStringToRil(&pStrings[i], data[i], pRI)) {
-            for (int j = 0; j < i; j++) {
-                memsetAndFreeStrings(1, pStrings[j]);
-            }
-            free(pStrings);
-            return false;
-        }
+        pStrings[i] = packString(&cursor, data[i].c_str(), data[i].size(), false);
     }
 
-    // free memory when RIL_onRequestComplete
-    auto cb = [](void *data, size_t dataLen) {
-        int countStrings = dataLen / sizeof(char *);
-        char **pStrings = (char **)data;
-
-        if (pStrings != NULL) {
-            for (int i = 0; i < countStrings; i++) {
-                memsetAndFreeStrings(1, pStrings[i]);
-            }
-            memset(pStrings, 0, dataLen);
-            free(pStrings);
-        }
-    };
-    REQUEST_INFO_PACK(pRI, cb, pStrings, countStrings * sizeof(char *));
+    REQUEST_INFO_PACK(pRI, memsetPackedStrings, pStrings, countStrings * sizeof(char *));
 
     CALL_ONREQUEST(request, pStrings, countStrings * sizeof(char *), pRI, pRI->socket_id);
 
@@ -1029,18 +1030,13 @@ bool dispatchStrings(int serial, int slotId, int request, const hidl_vec<hidl_st
 }
 
 bool dispatchInts(int serial, int slotId, int request, int countInts, ...) {
-    RequestInfo *pRI = android::addRequestToList(serial, slotId, request);
+    RequestInfo *pRI = android::addRequestToListWithPayload(serial, slotId, request,
+            countInts * sizeof(int));
     if (pRI == NULL) {
         return false;
     }
 
-    int *pInts = (int *)calloc(countInts, sizeof(int));
-
-    if (pInts == NULL) {
-        RLOGE("Memory allocation failed for request %s", requestToString(request));
-        sendErrorResponse(pRI, RIL_E_NO_MEMORY);
-        return false;
-    }
+    int *pInts = (int *)REQUEST_INFO_PAYLOAD(pRI);
     va_list ap;
     va_start(ap, countInts);
     for (int i = 0; i < countInts; i++) {
@@ -1048,12 +1044,7 @@ bool dispatchInts(int serial, int slotId, int request, int countInts, ...) {
     }
     va_end(ap);
 
-    // free memory when RIL_onRequestComplete
-    auto cb = [](void *data, size_t dataLen) {
-        memset(data, 0, dataLen);
-        free(data);
-    };
-    REQUEST_INFO_PACK(pRI, cb, pInts, countInts * sizeof(int));
+    REQUEST_INFO_PACK(pRI, memsetPackedData, pInts, countInts * sizeof(int));
 
     CALL_ONREQUEST(request, pInts, countInts * sizeof(int), pRI, pRI->socket_id);
 
@@ -5133,39 +5124,29 @@ int radio::supplyNetworkDepersonalizationResponse(int slotId,
     return 0;
 }
 
-void stripNumberFromSipAddress(const char *sipAddress, char *number, int len) {
-    if (sipAddress == NULL || strlen(sipAddress) == 0
-            || number == NULL || len <= 0) {
-        return;
-    }
-
-    memset(number, 0, len * sizeof(char));
+/**
+ * The number of a SIP address is the text between its first and second
+ * delimiter of ":;@", an address without any delimiter is a number itself.
+ * Only a stripped number is copied, a plain one is referenced.
+ */
+hidl_string convertSipAddressToHidlString(const char *sipAddress) {
+    const char *delim = ":;@";
+    const char *number = NULL;
 
-    char delim[] = ":;@";
-    char *strDupSipAddr = strdup(sipAddress);
-    char *s = strDupSipAddr;
-    char *token = strsep(&s, delim);
-    if (token != NULL) {
-        if (strlen(token) == strlen(sipAddress)) {
-            strncpy(number, sipAddress, len);
-            goto EXIT;
-        }
-        token = strsep(&s, delim);
-        if (token == NULL) {
-            strncpy(number, sipAddress, len);
-            goto EXIT;
-        } else {
-            strncpy(number, token, len);
-            goto EXIT;
-        }
+    if (sipAddress == NULL) {
+        return hidl_string();
     }
-    strncpy(number, sipAddress, len);
-
-EXIT:
-    if (s != NULL) {
-        free(strDupSipAddr);
-        strDupSipAddr = NULL;
+    number = strpbrk(sipAddress, delim);
+    if (number == NULL) {
+        return convertCharPtrToHidlString(sipAddress);
     }
+    number++;
+    return hidl_string(number, strcspn(number, delim));
+}
+
+/* uusData is not null-terminated and may be cut short by a null byte */
+hidl_string convertUusDataToHidlString(const RIL_UUS_Info *uusInfo) {
+    return hidl_string(uusInfo->uusData, strnlen(uusInfo->uusData, uusInfo->uusLength));
 }
 
 int radio::getCurrentCallsResponse(int slotId,
@@ -5180,7 +5161,6 @@ int radio::getCurrentCallsResponse(int slotId,
         RadioResponseInfo responseInfo = {};
         populateResponseInfo(responseInfo, serial, responseType, e);
 
-        char *numberTmp = NULL;
         Return<void> retStatus;
 
         if (radioService[slotId]->mRadioResponseV1_2 != NULL) {
@@ -5204,14 +5184,7 @@ int radio::getCurrentCallsResponse(int slotId,
                     calls[i].base.als = p_cur->als;
                     calls[i].base.isVoice = p_cur->isVoice;
                     calls[i].base.isVoicePrivacy = p_cur->isVoicePrivacy;
-                    if (p_cur->number != NULL) {
-                        numberTmp = strdup(p_cur->number);
-                        stripNumberFromSipAddress(p_cur->number, numberTmp,
-                                strlen(numberTmp) * sizeof(char));
-                        calls[i].base.number = convertCharPtrToHidlString(numberTmp);
-                    } else {
-                        calls[i].base.number = convertCharPtrToHidlString(p_cur->number);
-                    }
+                    calls[i].base.number = convertSipAddressToHidlString(p_cur->number);
                     calls[i].base.numberPresentation = (CallPresentation) p_cur->numberPresentation;
                     calls[i].base.name = convertCharPtrToHidlString(p_cur->name);
                     calls[i].base.namePresentation = (CallPresentation) p_cur->namePresentation;
@@ -5220,10 +5193,7 @@ int radio::getCurrentCallsResponse(int slotId,
                         calls[i].base.uusInfo.resize(1);
                         calls[i].base.uusInfo[0].uusType = (UusType) uusInfo->uusType;
                         calls[i].base.uusInfo[0].uusDcs = (UusDcs) uusInfo->uusDcs;
-                        // convert uusInfo->uusData to a null-terminated string
-                        char *nullTermStr = strndup(uusInfo->uusData, uusInfo->uusLength);
-                        calls[i].base.uusInfo[0].uusData = nullTermStr;
-                        free(nullTermStr);
+                        calls[i].base.uusInfo[0].uusData = convertUusDataToHidlString(uusInfo);
                     }
                     calls[i].audioQuality = (V1_2::AudioQuality)p_cur->audioQuality;
                 }
@@ -5252,14 +5222,7 @@ int radio::getCurrentCallsResponse(int slotId,
                     calls[i].als = p_cur->als;
                     calls[i].isVoice = p_cur->isVoice;
                     calls[i].isVoicePrivacy = p_cur->isVoicePrivacy;
-                    if (p_cur->number != NULL) {
-                        numberTmp = strdup(p_cur->number);
-                        stripNumberFromSipAddress(p_cur->number, numberTmp,
-                                strlen(numberTmp) * sizeof(char));
-                        calls[i].number = convertCharPtrToHidlString(numberTmp);
-                    } else {
-                        calls[i].number = convertCharPtrToHidlString(p_cur->number);
-                    }
+                    calls[i].number = convertSipAddressToHidlString(p_cur->number);
                     calls[i].numberPresentation = (CallPresentation) p_cur->numberPresentation;
                     calls[i].name = convertCharPtrToHidlString(p_cur->name);
                     calls[i].namePresentation = (CallPresentation) p_cur->namePresentation;
@@ -5268,10 +5231,7 @@ int radio::getCurrentCallsResponse(int slotId,
                         calls[i].uusInfo.resize(1);
                         calls[i].uusInfo[0].uusType = (UusType) uusInfo->uusType;
                         calls[i].uusInfo[0].uusDcs = (UusDcs) uusInfo->uusDcs;
-                        // convert uusInfo->uusData to a null-terminated string
-                        char *nullTermStr = strndup(uusInfo->uusData, uusInfo->uusLength);
-                        calls[i].uusInfo[0].uusData = nullTermStr;
-                        free(nullTermStr);
+                        calls[i].uusInfo[0].uusData = convertUusDataToHidlString(uusInfo);
                     }
                 }
             }
@@ -5280,7 +5240,6 @@ int radio::getCurrentCallsResponse(int slotId,
                     getCurrentCallsResponse(responseInfo, calls);
         }
         radioService[slotId]->checkReturnStatus(retStatus);
-        free(numberTmp);
     } else {
         RLOGE("getCurrentCallsResponse: radioService[%d]->mRadioResponse == NULL", slotId);
     }
@@ -10292,6 +10251,82 @@ void convertRilDataCallListToHal_1_4(void *response, size_t responseLen,
     }
 }
 
+static bool isHidlStringEqual(const hidl_string& str, const char *ptr) {
+    return strcmp(str.c_str(), ptr == NULL ? "" : ptr) == 0;
+}
+
+static bool isHidlStringListEqual(const hidl_vec<hidl_string>& list,
+        char **ptrs, uint32_t num) {
+    if (list.size() != num) {
+        return false;
+    }
+    for (uint32_t i = 0; i < num; i++) {
+        if (!isHidlStringEqual(list[i], ptrs[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* whether the converted data call is still the same as the RIL one */
+static bool isSameDataCall_1_4(const V1_4::SetupDataCallResult& dcResult,
+        RIL_SetupDataCallResult_v1_4 *dcResponse) {
+    return dcResult.cause == (V1_4::DataCallFailCause)dcResponse->cause
+            && dcResult.suggestedRetryTime == dcResponse->suggestedRetryTime
+            && dcResult.cid == dcResponse->cid
+            && dcResult.active == (V1_4::DataConnActiveStatus)dcResponse->active
+            && dcResult.type == (V1_4::PdpProtocolType)dcResponse->type
+            && dcResult.mtu == dcResponse->mtu
+            && isHidlStringEqual(dcResult.ifname, dcResponse->ifname)
+            && isHidlStringListEqual(dcResult.addresses, dcResponse->addresses,
+                                     dcResponse->addressesNumber)
+            && isHidlStringListEqual(dcResult.dnses, dcResponse->dnses,
+                                     dcResponse->dnsesNumber)
+            && isHidlStringListEqual(dcResult.gateways, dcResponse->gateways,
+                                     dcResponse->gatewaysNumber)
+            && isHidlStringListEqual(dcResult.pcscf, dcResponse->pcscf,
+                                     dcResponse->pcscfNumber);
+}
+
+/* makes the strings of a cached data call own their characters */
+static void ownDataCallStrings_1_4(V1_4::SetupDataCallResult& dcResult) {
+    dcResult.ifname = hidl_string(dcResult.ifname);
+    for (hidl_string& str : dcResult.addresses) str = hidl_string(str);
+    for (hidl_string& str : dcResult.dnses) str = hidl_string(str);
+    for (hidl_string& str : dcResult.gateways) str = hidl_string(str);
+    for (hidl_string& str : dcResult.pcscf) str = hidl_string(str);
+}
+
+/* last converted data call list of each slot, unchanged entries are reused */
+static hidl_vec<V1_4::SetupDataCallResult> s_dataCallListCache[SIM_COUNT];
+static pthread_mutex_t s_dataCallListCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* s_dataCallListCacheMutex must be held by caller */
+static const hidl_vec<V1_4::SetupDataCallResult>& updateDataCallListCache_1_4(
+        int slotId, void *response, size_t responseLen) {
+    int num = responseLen / sizeof(RIL_SetupDataCallResult_v1_4);
+    hidl_vec<V1_4::SetupDataCallResult>& cache = s_dataCallListCache[slotId];
+    RIL_SetupDataCallResult_v1_4 *dcResponse = (RIL_SetupDataCallResult_v1_4 *) response;
+
+    if (response == NULL) {
+        cache.resize(0);
+    } else if ((int)cache.size() != num) {
+        cache.resize(num);
+        for (int i = 0; i < num; i++) {
+            convertRilDataCallToHal_1_4(&dcResponse[i], cache[i]);
+            ownDataCallStrings_1_4(cache[i]);
+        }
+    } else {
+        for (int i = 0; i < num; i++) {
+            if (!isSameDataCall_1_4(cache[i], &dcResponse[i])) {
+                convertRilDataCallToHal_1_4(&dcResponse[i], cache[i]);
+                ownDataCallStrings_1_4(cache[i]);
+            }
+        }
+    }
+    return cache;
+}
+
 int radio::dataCallListChangedInd(int slotId,
                                   int indicationType, int token, RIL_Errno e, void *response,
                                   size_t responseLen) {
@@ -10307,11 +10342,13 @@ int radio::dataCallListChangedInd(int slotId,
 #endif
         Return<void> retStatus;
         if (radioService[slotId]->mRadioIndicationV1_4 != NULL) {
-            hidl_vec<V1_4::SetupDataCallResult> dcList;
-            convertRilDataCallListToHal_1_4(response, responseLen, dcList);
+            pthread_mutex_lock(&s_dataCallListCacheMutex);
+            const hidl_vec<V1_4::SetupDataCallResult>& dcList =
+                    updateDataCallListCache_1_4(slotId, response, responseLen);
 
             retStatus = radioService[slotId]->mRadioIndicationV1_4->dataCallListChanged_1_4(
                 convertIntToRadioIndicationType(indicationType), dcList);
+            pthread_mutex_unlock(&s_dataCallListCacheMutex);
         } else {
             hidl_vec<SetupDataCallResult> dcList;
             convertRilDataCallListToHal(response, responseLen, dcList);
@@ -11530,7 +11567,7 @@ void convertRilCellInfoListToHal_1_4(void *response, size_t responseLen, hidl_ve
                         rillCellInfo->CellInfo.gsm.signalStrengthGsm.bitErrorRate;
                 cellInfoGsm.signalStrengthGsm.timingAdvance =
                         rillCellInfo->CellInfo.gsm.signalStrengthGsm.timingAdvance;
-                records[i].info.gsm(cellInfoGsm);
+                records[i].info.gsm(std::move(cellInfoGsm));
                 break;
             }
 
@@ -11574,7 +11611,7 @@ void convertRilCellInfoListToHal_1_4(void *response, size_t responseLen, hidl_ve
                         rillCellInfo->CellInfo.wcdma.signalStrengthWcdma.rscp;
                 cellInfoWcdma.signalStrengthWcdma.ecno =
                         rillCellInfo->CellInfo.wcdma.signalStrengthWcdma.ecno;
-                records[i].info.wcdma(cellInfoWcdma);
+                records[i].info.wcdma(std::move(cellInfoWcdma));
                 break;
             }
 
@@ -11607,7 +11644,7 @@ void convertRilCellInfoListToHal_1_4(void *response, size_t responseLen, hidl_ve
                         rillCellInfo->CellInfo.cdma.signalStrengthEvdo.ecio;
                 cellInfoCdma.signalStrengthEvdo.signalNoiseRatio =
                         rillCellInfo->CellInfo.cdma.signalStrengthEvdo.signalNoiseRatio;
-                records[i].info.cdma(cellInfoCdma);
+                records[i].info.cdma(std::move(cellInfoCdma));
                 break;
             }
 
@@ -11661,7 +11698,7 @@ void convertRilCellInfoListToHal_1_4(void *response, size_t responseLen, hidl_ve
 
                 cellInfoLte.cellConfig.isEndcAvailable =
                         rillCellInfo->CellInfo.lte.cellConfig.isEndcAvailable;
-                records[i].info.lte(cellInfoLte);
+                records[i].info.lte(std::move(cellInfoLte));
                 break;
             }
 
@@ -11699,7 +11736,7 @@ void convertRilCellInfoListToHal_1_4(void *response, size_t responseLen, hidl_ve
 
                 cellInfoTdscdma.signalStrengthTdscdma.rscp =
                         rillCellInfo->CellInfo.tdscdma.signalStrengthTdscdma.rscp;
-                records[i].info.tdscdma(cellInfoTdscdma);
+                records[i].info.tdscdma(std::move(cellInfoTdscdma));
                 break;
             }
             case RIL_CELL_INFO_TYPE_NR: {
@@ -11745,7 +11782,7 @@ void convertRilCellInfoListToHal_1_4(void *response, size_t responseLen, hidl_ve
                         rillCellInfo->CellInfo.nr.signalStrength.csiRsrq;
                 cellInfoNr.signalStrength.csiSinr =
                         rillCellInfo->CellInfo.nr.signalStrength.csiSinr;
-                records[i].info.nr(cellInfoNr);
+                records[i].info.nr(std::move(cellInfoNr));
                 break;
             }
             default: {
@@ -14801,7 +14838,6 @@ int radio::getIMSCurrentCallsResponse(int slotId, int responseType, int serial,
         ExtRadioResponseInfo responseInfo = {};
         populateResponseInfoExt(responseInfo, serial, responseType, e);
 
-        char *numberTmp = NULL;
         hidl_vec<CallVoLTE> calls;
         if (response == NULL || (responseLen % sizeof(RIL_Call_VoLTE *)) != 0) {
             RLOGE("getIMSCurrentCallsResponse: Invalid response");
@@ -14823,14 +14859,7 @@ int radio::getIMSCurrentCallsResponse(int slotId, int responseType, int serial,
                 calls[i].mpty = p_cur->mpty;
                 calls[i].numberType = p_cur->numberType;
                 calls[i].toa = p_cur->toa;
-                if (p_cur->number != NULL) {
-                    numberTmp = strdup(p_cur->number);
-                    stripNumberFromSipAddress(p_cur->number, numberTmp,
-                            strlen(numberTmp) * sizeof(char));
-                    calls[i].number = convertCharPtrToHidlString(numberTmp);
-                } else {
-                    calls[i].number = convertCharPtrToHidlString(p_cur->number);
-                }
+                calls[i].number = convertSipAddressToHidlString(p_cur->number);
                 calls[i].prioritypresent = p_cur->prioritypresent;
                 calls[i].priority = p_cur->priority;
                 calls[i].cliValidityPresent = p_cur->CliValidityPresent;
@@ -14857,7 +14886,6 @@ int radio::getIMSCurrentCallsResponse(int slotId, int responseType, int serial,
         Return<void> retStatus = extRadioService[slotId]->mExtRadioResponse->
                 getIMSCurrentCallsResponse(responseInfo, calls);
         extRadioService[slotId]->checkReturnStatus(retStatus, RADIOINTERACTOR_SERVICE);
-        free(numberTmp);
     } else {
         RLOGE("getIMSCurrentCallsResponse: radioService[%d]->mExtRadioResponse == NULL", slotId);
     }
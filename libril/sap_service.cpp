@@ -65,9 +65,10 @@ struct SapImpl : public android::hardware::radio::V1_2::ISap {
 
     Return<void> setTransferProtocolReq(int32_t token, SapTransferProtocol transferProtocol);
 
-    MsgHeader* createMsgHeader(MsgId msgId, int32_t token);
+    MsgHeader* createMsgHeader(MsgId msgId, int32_t token, size_t payloadLen);
 
-    Return<void> addPayloadAndDispatchRequest(MsgHeader *msg, uint16_t reqLen, uint8_t *reqPtr);
+    Return<void> encodeAndDispatchRequest(MsgId msgId, int32_t token,
+            const pb_field_t fields[], const void *req);
 
     void sendFailedResponse(MsgId msgId, int32_t token, int numPointers, ...);
 
@@ -91,42 +92,67 @@ Return<void> SapImpl::setCallback(const ::android::sp<ISapCallback>& sapCallback
     return Void();
 }
 
-MsgHeader* SapImpl::createMsgHeader(MsgId msgId, int32_t token) {
+/* MsgHeader followed by its payload, see createMsgHeader() */
+typedef struct {
+    MsgHeader header;
+    pb_bytes_array_t payload;   /* runs past the end of the struct */
+} SapRequestMsg;
+
+/* APDUs up to this size are staged on the stack, short APDUs are at most 261 */
+#define SAP_APDU_INLINE_SIZE    512
+
+MsgHeader* SapImpl::createMsgHeader(MsgId msgId, int32_t token, size_t payloadLen) {
     // Memory for msg will be freed by RilSapSocket::onRequestComplete()
-    MsgHeader *msg = (MsgHeader *)calloc(1, sizeof(MsgHeader));
-    if (msg == NULL) {
+    // header and payload are a single allocation so that one free() releases both
+    SapRequestMsg *block = (SapRequestMsg *)calloc(1, sizeof(SapRequestMsg) + payloadLen);
+    if (block == NULL) {
         return NULL;
     }
+    MsgHeader *msg = &block->header;
     msg->token = token;
     msg->type = MsgType_REQUEST;
     msg->id = msgId;
     msg->error = Error_RIL_E_SUCCESS;
+    msg->payload = &block->payload;
     return msg;
 }
 
-Return<void> SapImpl::addPayloadAndDispatchRequest(MsgHeader *msg, uint16_t reqLen,
-        uint8_t *reqPtr) {
-    pb_bytes_array_t *payload = (pb_bytes_array_t *) malloc(sizeof(pb_bytes_array_t) - 1 + reqLen);
-    if (payload == NULL) {
-        sendFailedResponse(msg->id, msg->token, 2, reqPtr, msg);
+Return<void> SapImpl::encodeAndDispatchRequest(MsgId msgId, int32_t token,
+        const pb_field_t fields[], const void *req) {
+    size_t encodedSize = 0;
+    if (!pb_get_encoded_size(&encodedSize, fields, req)) {
+        RLOGE("SapImpl::encodeAndDispatchRequest: Error getting encoded size for msgId %d",
+                msgId);
+        sendFailedResponse(msgId, token, 0);
         return Void();
     }
 
-    msg->payload = payload;
-    msg->payload->size = reqLen;
-    memcpy(msg->payload->bytes, reqPtr, reqLen);
+    MsgHeader *msg = createMsgHeader(msgId, token, encodedSize);
+    if (msg == NULL) {
+        RLOGE("SapImpl::encodeAndDispatchRequest: Error allocating memory for msg");
+        sendFailedResponse(msgId, token, 0);
+        return Void();
+    }
+
+    /* encoded req is payload */
+    pb_ostream_t stream = pb_ostream_from_buffer(msg->payload->bytes, encodedSize);
+
+    RLOGD("SapImpl::encodeAndDispatchRequest calling pb_encode for msgId %d", msgId);
+    if (!pb_encode(&stream, fields, req)) {
+        RLOGE("SapImpl::encodeAndDispatchRequest: Error encoding msgId %d", msgId);
+        sendFailedResponse(msgId, token, 1, msg);
+        return Void();
+    }
+    msg->payload->size = stream.bytes_written;
 
     RilSapSocket *sapSocket = RilSapSocket::getSocketById(rilSocketId);
     if (sapSocket) {
-        RLOGD("SapImpl::addPayloadAndDispatchRequest: calling dispatchRequest");
+        RLOGD("SapImpl::encodeAndDispatchRequest: calling dispatchRequest");
         sapSocket->dispatchRequest(msg);
     } else {
-        RLOGE("SapImpl::addPayloadAndDispatchRequest: sapSocket is null");
-        sendFailedResponse(msg->id, msg->token, 3, payload, reqPtr, msg);
-        return Void();
+        RLOGE("SapImpl::encodeAndDispatchRequest: sapSocket is null");
+        sendFailedResponse(msgId, token, 1, msg);
     }
-    free(msg->payload);
-    free(reqPtr);
     return Void();
 }
 
@@ -186,478 +212,190 @@ void SapImpl::sendFailedResponse(MsgId msgId, int32_t token, int numPointers, ..
 
 Return<void> SapImpl::connectReq(int32_t token, int32_t maxMsgSize) {
     RLOGD("SapImpl::connectReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_CONNECT, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::connectReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_CONNECT, token, 0);
-        return Void();
-    }
-
-    /***** Encode RIL_SIM_SAP_CONNECT_REQ *****/
     RIL_SIM_SAP_CONNECT_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_CONNECT_REQ));
     req.max_message_size = maxMsgSize;
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_CONNECT_REQ_fields, &req)) {
-        RLOGE("SapImpl::connectReq: Error getting encoded size for RIL_SIM_SAP_CONNECT_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_CONNECT, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::connectReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_CONNECT, token, 1, msg);
-        return Void();
-    }
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::connectReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_CONNECT_REQ_fields, &req)) {
-        RLOGE("SapImpl::connectReq: Error encoding RIL_SIM_SAP_CONNECT_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_CONNECT, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_CONNECT_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_CONNECT, token,
+            RIL_SIM_SAP_CONNECT_REQ_fields, &req);
 }
 
 Return<void> SapImpl::disconnectReq(int32_t token) {
     RLOGD("SapImpl::disconnectReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_DISCONNECT, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::disconnectReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_DISCONNECT, token, 0);
-        return Void();
-    }
-
-    /***** Encode RIL_SIM_SAP_DISCONNECT_REQ *****/
     RIL_SIM_SAP_DISCONNECT_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_DISCONNECT_REQ));
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_DISCONNECT_REQ_fields, &req)) {
-        RLOGE("SapImpl::disconnectReq: Error getting encoded size for RIL_SIM_SAP_DISCONNECT_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_DISCONNECT, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::disconnectReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_DISCONNECT, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::disconnectReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_DISCONNECT_REQ_fields, &req)) {
-        RLOGE("SapImpl::disconnectReq: Error encoding RIL_SIM_SAP_DISCONNECT_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_DISCONNECT, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_DISCONNECT_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_DISCONNECT, token,
+            RIL_SIM_SAP_DISCONNECT_REQ_fields, &req);
 }
 
 Return<void> SapImpl::apduReq(int32_t token, SapApduType type, const hidl_vec<uint8_t>& command) {
     RLOGD("SapImpl::apduReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_APDU, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::apduReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 0);
-        return Void();
-    }
-
-    /***** Encode RIL_SIM_SAP_APDU_REQ *****/
     RIL_SIM_SAP_APDU_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_APDU_REQ));
     req.type = (RIL_SIM_SAP_APDU_REQ_Type)type;
 
-    if (command.size() > 0) {
+    union {
+        pb_bytes_array_t array;
+        uint8_t raw[sizeof(pb_bytes_array_t) + SAP_APDU_INLINE_SIZE];
+    } inlineCommand;
+
+    if (command.size() > SAP_APDU_INLINE_SIZE) {
         req.command = (pb_bytes_array_t *)malloc(sizeof(pb_bytes_array_t) - 1 + command.size());
         if (req.command == NULL) {
             RLOGE("SapImpl::apduReq: Error allocating memory for req.command");
-            sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 1, msg);
+            sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 0);
             return Void();
         }
+    } else if (command.size() > 0) {
+        req.command = &inlineCommand.array;
+    }
+    if (req.command != NULL) {
         req.command->size = command.size();
         memcpy(req.command->bytes, command.data(), command.size());
     }
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_APDU_REQ_fields, &req)) {
-        RLOGE("SapImpl::apduReq: Error getting encoded size for RIL_SIM_SAP_APDU_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 2, req.command, msg);
-        return Void();
+    Return<void> ret = encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_APDU, token,
+            RIL_SIM_SAP_APDU_REQ_fields, &req);
+    if (req.command != &inlineCommand.array) {
+        free(req.command);
     }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::apduReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 2, req.command, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::apduReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_APDU_REQ_fields, &req)) {
-        RLOGE("SapImpl::apduReq: Error encoding RIL_SIM_SAP_APDU_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 3, req.command, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_APDU_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return ret;
 }
 
 Return<void> SapImpl::transferAtrReq(int32_t token) {
     RLOGD("SapImpl::transferAtrReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::transferAtrReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token, 0);
-        return Void();
-    }
-
-    /***** Encode RIL_SIM_SAP_TRANSFER_ATR_REQ *****/
     RIL_SIM_SAP_TRANSFER_ATR_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_TRANSFER_ATR_REQ));
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_TRANSFER_ATR_REQ_fields, &req)) {
-        RLOGE("SapImpl::transferAtrReq: Error getting encoded size for "
-                "RIL_SIM_SAP_TRANSFER_ATR_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::transferAtrReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::transferAtrReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_TRANSFER_ATR_REQ_fields, &req)) {
-        RLOGE("SapImpl::transferAtrReq: Error encoding RIL_SIM_SAP_TRANSFER_ATR_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_TRANSFER_ATR_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token,
+            RIL_SIM_SAP_TRANSFER_ATR_REQ_fields, &req);
 }
 
 Return<void> SapImpl::powerReq(int32_t token, bool state) {
     RLOGD("SapImpl::powerReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_POWER, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::powerReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_POWER, token, 0);
-        return Void();
-    }
-
-    /***** Encode RIL_SIM_SAP_POWER_REQ *****/
     RIL_SIM_SAP_POWER_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_POWER_REQ));
     req.state = state;
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_POWER_REQ_fields, &req)) {
-        RLOGE("SapImpl::powerReq: Error getting encoded size for RIL_SIM_SAP_POWER_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_POWER, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::powerReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_POWER, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::powerReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_POWER_REQ_fields, &req)) {
-        RLOGE("SapImpl::powerReq: Error encoding RIL_SIM_SAP_POWER_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_POWER, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_POWER_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_POWER, token,
+            RIL_SIM_SAP_POWER_REQ_fields, &req);
 }
 
 Return<void> SapImpl::resetSimReq(int32_t token) {
     RLOGD("SapImpl::resetSimReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_RESET_SIM, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::resetSimReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_RESET_SIM, token, 0);
-        return Void();
-    }
-
-    /***** Encode RIL_SIM_SAP_RESET_SIM_REQ *****/
     RIL_SIM_SAP_RESET_SIM_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_RESET_SIM_REQ));
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_RESET_SIM_REQ_fields, &req)) {
-        RLOGE("SapImpl::resetSimReq: Error getting encoded size for RIL_SIM_SAP_RESET_SIM_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_RESET_SIM, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::resetSimReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_RESET_SIM, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::resetSimReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_RESET_SIM_REQ_fields, &req)) {
-        RLOGE("SapImpl::resetSimReq: Error encoding RIL_SIM_SAP_RESET_SIM_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_RESET_SIM, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_RESET_SIM_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_RESET_SIM, token,
+            RIL_SIM_SAP_RESET_SIM_REQ_fields, &req);
 }
 
 Return<void> SapImpl::transferCardReaderStatusReq(int32_t token) {
     RLOGD("SapImpl::transferCardReaderStatusReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::transferCardReaderStatusReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token, 0);
-        return Void();
-    }
-
-    /***** Encode RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ *****/
     RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ));
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ_fields,
-            &req)) {
-        RLOGE("SapImpl::transferCardReaderStatusReq: Error getting encoded size for "
-                "RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::transferCardReaderStatusReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::transferCardReaderStatusReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ_fields, &req)) {
-        RLOGE("SapImpl::transferCardReaderStatusReq: Error encoding "
-                "RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token,
+            RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ_fields, &req);
 }
 
 Return<void> SapImpl::setTransferProtocolReq(int32_t token, SapTransferProtocol transferProtocol) {
     RLOGD("SapImpl::setTransferProtocolReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::setTransferProtocolReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token, 0);
-        return Void();
-    }
-
-    /***** Encode RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ *****/
     RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ));
     req.protocol = (RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ_Protocol)transferProtocol;
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ_fields, &req)) {
-        RLOGE("SapImpl::setTransferProtocolReq: Error getting encoded size for "
-                "RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::setTransferProtocolReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::setTransferProtocolReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ_fields, &req)) {
-        RLOGE("SapImpl::setTransferProtocolReq: Error encoding "
-                "RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token,
+            RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ_fields, &req);
 }
 
-void *sapDecodeMessage(MsgId msgId, MsgType msgType, uint8_t *payloadPtr, size_t payloadLen) {
-    void *responsePtr = NULL;
+/* every message sapDecodeMessage() can produce */
+typedef union {
+    RIL_SIM_SAP_CONNECT_RSP connectRsp;
+    RIL_SIM_SAP_DISCONNECT_RSP disconnectRsp;
+    RIL_SIM_SAP_DISCONNECT_IND disconnectInd;
+    RIL_SIM_SAP_APDU_RSP apduRsp;
+    RIL_SIM_SAP_TRANSFER_ATR_RSP transferAtrRsp;
+    RIL_SIM_SAP_POWER_RSP powerRsp;
+    RIL_SIM_SAP_RESET_SIM_RSP resetSimRsp;
+    RIL_SIM_SAP_STATUS_IND statusInd;
+    RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_RSP transferCardReaderStatusRsp;
+    RIL_SIM_SAP_ERROR_RSP errorRsp;
+    RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_RSP setTransferProtocolRsp;
+} SapMessage;
+
+/**
+ * Decodes the payload into message, which lives on the caller's stack.
+ * Returns the fields the message was decoded with, the caller must
+ * pb_release() them when done, or NULL on error (nothing to release).
+ */
+const pb_field_t *sapDecodeMessage(MsgId msgId, MsgType msgType, uint8_t *payloadPtr,
+        size_t payloadLen, SapMessage *message) {
+    const pb_field_t *fields = NULL;
     pb_istream_t stream;
 
-    /* Create the stream */
-    stream = pb_istream_from_buffer((uint8_t *)payloadPtr, payloadLen);
-
     /* Decode based on the message id */
     switch (msgId)
     {
         case MsgId_RIL_SIM_SAP_CONNECT:
-            responsePtr = malloc(sizeof(RIL_SIM_SAP_CONNECT_RSP));
-            if (responsePtr) {
-                if (!pb_decode(&stream, RIL_SIM_SAP_CONNECT_RSP_fields, responsePtr)) {
-                    RLOGE("Error decoding RIL_SIM_SAP_CONNECT_RSP");
-                    return NULL;
-                }
-            }
+            fields = RIL_SIM_SAP_CONNECT_RSP_fields;
             break;
 
         case MsgId_RIL_SIM_SAP_DISCONNECT:
             if (msgType == MsgType_RESPONSE) {
-                responsePtr = malloc(sizeof(RIL_SIM_SAP_DISCONNECT_RSP));
-                if (responsePtr) {
-                    if (!pb_decode(&stream, RIL_SIM_SAP_DISCONNECT_RSP_fields, responsePtr)) {
-                        RLOGE("Error decoding RIL_SIM_SAP_DISCONNECT_RSP");
-                        return NULL;
-                    }
-                }
+                fields = RIL_SIM_SAP_DISCONNECT_RSP_fields;
             } else {
-                responsePtr = malloc(sizeof(RIL_SIM_SAP_DISCONNECT_IND));
-                if (responsePtr) {
-                    if (!pb_decode(&stream, RIL_SIM_SAP_DISCONNECT_IND_fields, responsePtr)) {
-                        RLOGE("Error decoding RIL_SIM_SAP_DISCONNECT_IND");
-                        return NULL;
-                    }
-                }
+                fields = RIL_SIM_SAP_DISCONNECT_IND_fields;
             }
             break;
 
         case MsgId_RIL_SIM_SAP_APDU:
-            responsePtr = malloc(sizeof(RIL_SIM_SAP_APDU_RSP));
-            if (responsePtr) {
-                if (!pb_decode(&stream, RIL_SIM_SAP_APDU_RSP_fields, responsePtr)) {
-                    RLOGE("Error decoding RIL_SIM_SAP_APDU_RSP");
-                    return NULL;
-                }
-            }
+            fields = RIL_SIM_SAP_APDU_RSP_fields;
             break;
 
         case MsgId_RIL_SIM_SAP_TRANSFER_ATR:
-            responsePtr = malloc(sizeof(RIL_SIM_SAP_TRANSFER_ATR_RSP));
-            if (responsePtr) {
-                if (!pb_decode(&stream, RIL_SIM_SAP_TRANSFER_ATR_RSP_fields, responsePtr)) {
-                    RLOGE("Error decoding RIL_SIM_SAP_TRANSFER_ATR_RSP");
-                    return NULL;
-                }
-            }
+            fields = RIL_SIM_SAP_TRANSFER_ATR_RSP_fields;
             break;
 
         case MsgId_RIL_SIM_SAP_POWER:
-            responsePtr = malloc(sizeof(RIL_SIM_SAP_POWER_RSP));
-            if (responsePtr) {
-                if (!pb_decode(&stream, RIL_SIM_SAP_POWER_RSP_fields, responsePtr)) {
-                    RLOGE("Error decoding RIL_SIM_SAP_POWER_RSP");
-                    return NULL;
-                }
-            }
+            fields = RIL_SIM_SAP_POWER_RSP_fields;
             break;
 
         case MsgId_RIL_SIM_SAP_RESET_SIM:
-            responsePtr = malloc(sizeof(RIL_SIM_SAP_RESET_SIM_RSP));
-            if (responsePtr) {
-                if (!pb_decode(&stream, RIL_SIM_SAP_RESET_SIM_RSP_fields, responsePtr)) {
-                    RLOGE("Error decoding RIL_SIM_SAP_RESET_SIM_RSP");
-                    return NULL;
-                }
-            }
+            fields = RIL_SIM_SAP_RESET_SIM_RSP_fields;
             break;
 
         case MsgId_RIL_SIM_SAP_STATUS:
-            responsePtr = malloc(sizeof(RIL_SIM_SAP_STATUS_IND));
-            if (responsePtr) {
-                if (!pb_decode(&stream, RIL_SIM_SAP_STATUS_IND_fields, responsePtr)) {
-                    RLOGE("Error decoding RIL_SIM_SAP_STATUS_IND");
-                    return NULL;
-                }
-            }
+            fields = RIL_SIM_SAP_STATUS_IND_fields;
             break;
 
         case MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS:
-            responsePtr = malloc(sizeof(RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_RSP));
-            if (responsePtr) {
-                if (!pb_decode(&stream, RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_RSP_fields,
-                        responsePtr)) {
-                    RLOGE("Error decoding RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_RSP");
-                    return NULL;
-                }
-            }
+            fields = RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_RSP_fields;
             break;
 
         case MsgId_RIL_SIM_SAP_ERROR_RESP:
-            responsePtr = malloc(sizeof(RIL_SIM_SAP_ERROR_RSP));
-            if (responsePtr) {
-                if (!pb_decode(&stream, RIL_SIM_SAP_ERROR_RSP_fields, responsePtr)) {
-                    RLOGE("Error decoding RIL_SIM_SAP_ERROR_RSP");
-                    return NULL;
-                }
-            }
+            fields = RIL_SIM_SAP_ERROR_RSP_fields;
             break;
 
         case MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL:
-            responsePtr = malloc(sizeof(RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_RSP));
-            if (responsePtr) {
-                if (!pb_decode(&stream, RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_RSP_fields,
-                        responsePtr)) {
-                    RLOGE("Error decoding RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_RSP");
-                    return NULL;
-                }
-            }
+            fields = RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_RSP_fields;
             break;
 
         default:
-            break;
+            return NULL;
     }
-    return responsePtr;
+
+    /* Create the stream */
+    stream = pb_istream_from_buffer((uint8_t *)payloadPtr, payloadLen);
+
+    /* pb_decode() releases whatever it allocated if it fails */
+    memset(message, 0, sizeof(SapMessage));
+    if (!pb_decode(&stream, fields, message)) {
+        RLOGE("Error decoding msgId %d msgType %d: %s", msgId, msgType, PB_GET_ERROR(&stream));
+        return NULL;
+    }
+    return fields;
 } /* sapDecodeMessage */
 
 sp<SapImpl> getSapImpl(RilSapSocket *sapSocket) {
@@ -768,8 +506,6 @@ void processResponse(MsgHeader *rsp, RilSapSocket *sapSocket, MsgType msgType) {
     uint8_t *data = rsp->payload->bytes;
     size_t dataLen = rsp->payload->size;
 
-    void *messagePtr = sapDecodeMessage(msgId, msgType, data, dataLen);
-
     sp<SapImpl> sapImpl = getSapImpl(sapSocket);
     if (sapImpl->sapCallback == NULL) {
         RLOGE("processResponse: sapCallback == NULL; msgId = %d; msgType = %d",
@@ -777,6 +513,10 @@ void processResponse(MsgHeader *rsp, RilSapSocket *sapSocket, MsgType msgType) {
         return;
     }
 
+    SapMessage message;
+    const pb_field_t *fields = sapDecodeMessage(msgId, msgType, data, dataLen, &message);
+    void *messagePtr = fields != NULL ? &message : NULL;
+
     if (messagePtr == NULL) {
         RLOGE("processResponse: *messagePtr == NULL; msgId = %d; msgType = %d",
                 msgId, msgType);
@@ -910,8 +650,10 @@ void processResponse(MsgHeader *rsp, RilSapSocket *sapSocket, MsgType msgType) {
         }
 
         default:
-            return;
+            break;
     }
+    /* the APDU/ATR bytes were only lent to HIDL for the duration of the call */
+    pb_release(fields, &message);
     sapImpl->checkReturnStatus(retStatus);
 }
 
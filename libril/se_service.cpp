@@ -110,7 +110,6 @@ Return<void> SecureElementImpl::transmit(const hidl_vec<uint8_t>& data, transmit
     RLOGD("secure element transmit: mSlotId %d", mSlotId);
 #endif
     hidl_vec<uint8_t> response;
-    uint8_t *bytes = NULL;
     SE_APDU apdu, resp;
     memset(&apdu, 0, sizeof(SE_APDU));
     memset(&resp,0, sizeof(SE_APDU));
@@ -121,26 +120,19 @@ Return<void> SecureElementImpl::transmit(const hidl_vec<uint8_t>& data, transmit
         goto done;
     }
 
-    apdu.data = (uint8_t *)calloc(apdu.len, sizeof(uint8_t));
-    if (apdu.data == NULL) {
-        RLOGE("SE transmit calloc failed");
-        goto done;
-    }
-    memcpy(apdu.data, data.data(), apdu.len);
+    // transmitForSeService only reads the command APDU
+    apdu.data = const_cast<uint8_t *>(data.data());
 
     s_seFunctions->transmitForSeService(mSlotId, &apdu, &resp);
-    bytes = convertHexStringToBytes(resp.data, resp.len);
-    if (bytes == NULL) {
-        RLOGE("SE transmit convertHexStringToBytes failed");
+    if (resp.data == NULL) {
+        RLOGE("SE transmit failed");
         goto done;
     }
-    response.setToExternal(bytes, resp.len / 2);
+    response.setToExternal(resp.data, resp.len);
 
 done:
     _hidl_cb(response);
-    FREE(apdu.data);
     FREE(resp.data);
-    FREE(bytes);
     return Void();
 }
 